@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "types.h"
+
+// the strings are stored in pages, an offset is <page index, position in the page>
+#define ARENA_PAGE_SHIFT 16
+#define ARENA_PAGE_SIZE (1 << ARENA_PAGE_SHIFT)
+
+// the number of voters a chunk of the voter pool holds
+#define POOL_CHUNK_VOTERS 4096
+
+
+// Append-only storage for strings, that are referenced by 32-bit offsets
+
+// string arena handle - abstraction
+typedef struct _string_arena* string_arena;
+
+// creates a string arena
+string_arena arena_create(void);
+
+// copies the first n characters of the string at the arena, null-terminating the copy
+// returns the offset of the copy
+uint32_t arena_append(const string_arena, const char*, const size_t);
+
+// returns the string stored at the offset
+const char* arena_get(const string_arena, const uint32_t);
+
+// moves every string of the second arena to the first one and destroys the second one
+// returns the number that has to be added to the offsets of the second arena
+uint32_t arena_merge(const string_arena, const string_arena);
+
+// writes every page of the arena, in order, so that adopting them back keeps the offsets of the strings
+// returns the number of bytes written, false if writing failed
+bool arena_save(const string_arena, FILE*, size_t*);
+
+// adopts memory as the next pages of the arena, such as the pages written by arena_save
+// the memory has to be readable up to a whole number of pages and is not freed by the arena
+// input: <arena>, <memory>, <number of bytes>
+// returns the offset of the first byte of the memory, so adopting the pages of arena_save at an empty arena keeps the offsets of their strings
+uint32_t arena_adopt(const string_arena, char*, const size_t);
+
+// returns the number of bytes the arena has allocated, adopted memory excluded
+size_t arena_bytes(const string_arena);
+
+// destroys the memory used by the arena
+// and returns the number of bytes destroyed
+size_t arena_destroy(const string_arena);
+
+
+// Storage for voters, packed into contiguous chunks
+
+// voter pool handle - abstraction
+typedef struct _voter_pool* voter_pool;
+
+// creates a voter pool
+voter_pool pool_create(void);
+
+// returns the memory of a new voter
+voter pool_alloc(const voter_pool);
+
+// gives back a voter that is no longer used, so that its memory can be reused
+void pool_release(const voter_pool, const voter);
+
+// moves every voter of the second pool to the first one and destroys the second one
+// the voters keep their addresses
+void pool_merge(const voter_pool, const voter_pool);
+
+// writes every voter of the pool in a single array and remembers the position each one got
+// returns the number of voters written, false if writing failed
+bool pool_save(const voter_pool, FILE*, size_t*);
+
+// the position of the voter at the array written by the last pool_save
+uint32_t pool_position(const voter_pool, const voter);
+
+// adopts an array of voters, written by pool_save, into an empty pool
+// the array is not freed by the pool
+void pool_adopt(const voter_pool, const voter, const size_t);
+
+// returns the number of bytes the pool has allocated, adopted voters excluded
+size_t pool_bytes(const voter_pool);
+
+// destroys the memory used by the pool, along with every voter in it
+// and returns the number of bytes destroyed
+size_t pool_destroy(const voter_pool);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "types.h"
+
+// the bytes of commands read from stdin at once
+#define BATCH_BLOCK_SIZE (1 << 20)
+
+
+// runs the commands of stdin a block at a time, for feeders that pipe in lots of commands
+// the lines of a block are tokenized where they were read, and the responses & errors of the whole block
+// are written with a single write each once it is done
+// the pins of consecutive l & m lines are looked up together, with a single db_search_many
+// lines longer than a command buffer are reported as malformed
+// returns once exit is read or stdin ends
+void batch_run(const database);
@@ -1,23 +1,30 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "types.h"
 
-// 1 - l
+// the most pins a group of l & m commands gathers before it is run
+#define COMMAND_GROUP_PINS 4096
+
+// 1 - l <pin> [<pin> ...]
 void find_participant(const database);
 
 // 2 - i
 void insert_participant(const database db);
 
-// 3 - m
+// 3 - m <pin> [<pin> ...]
 void mark_voted(const database);
 
-// 4 - bv
+// 4 - bv <file> [-s]
 void voters_file(const database);
 
-// 5 - v
+// 5 - v [<first pin> <last pin> | z <zipcode>]
+// the number of voters among every participant, a range of pins or a zipcode
 void participants_num(const database db);
 
-// 6 - perc
+// 6 - perc [<first pin> <last pin> | z <zipcode>]
+// the percentage of voters among every participant, a range of pins or a zipcode
 void vote_percentage(const database db);
 
 // 7 - z
@@ -28,3 +35,58 @@ void postcode_voters(const database db);
 
 // 10 - p
 void print_db(const database);
+
+// 11 - save <file>
+void save_db(const database);
+
+// 12 - stats, see stats.h
+
+// 13 - d <pin>
+void delete_participant(const database);
+
+// 14 - r <first pin> <last pin>
+// the participants of a range of pins, in ascending order of pins
+void range_participants(const database);
+
+// 15 - rperc <first pin> <last pin>
+// the voters & the percentage of voters among the participants of a range of pins
+void range_percentage(const database);
+
+// 16 - top <k> [perc]
+// the k zipcodes with the most voters, or with the highest percentage of voters among their participants
+void top_postcodes(const database);
+
+// 17 - zt [<min percentage> [<max percentage>]]
+// the voters, participants & percentage of voters of every zipcode, or of those within the percentages
+void postcode_turnout(const database);
+
+// consecutive l & m commands, whose pins are looked up together with one db_search_many
+// a participant is only looked up by them, never inserted or removed, so every command of the group
+// responds as it would on its own, in order
+
+// command group handle - abstraction
+typedef struct _command_group* command_group;
+
+// creates an empty group
+command_group group_create(void);
+
+// returns true if the group has no commands
+bool group_empty(const command_group);
+
+// adds an l or m command read by read_command, along with its pins, to the group
+// the group is run first if the pins might not fit
+void group_add(const database, const command_group, const command_t);
+
+// looks up the pins of every command of the group at once, then runs the commands in order and empties the group
+void group_run(const database, const command_group);
+
+// destroys the memory used by the group
+void group_destroy(const command_group);
+
+// processes a line of input and tokenizes its command, leaving its arguments to the command
+// an empty line is reported, returning NO_COMMAND
+command_t read_command(char*);
+
+// runs a command read by read_command, writing at responses() & errors()
+// exit is left to the caller
+void run_command(const database, const command_t);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "linear_hashing.h"
+
+// the buckets are reached through a directory of fixed-size segments, like the single-threaded table
+#define CH_SEGMENT_SHIFT 8
+#define CH_SEGMENT_SIZE (1 << CH_SEGMENT_SHIFT)
+#define CH_SEGMENT_MASK (CH_SEGMENT_SIZE - 1)
+
+// the directory is allocated whole and never moves, so lookups can walk it without a lock
+// it can address CH_MAX_SEGMENTS * CH_SEGMENT_SIZE buckets, past that chains just get longer
+#define CH_MAX_SEGMENTS (1 << 16)
+
+
+// linear hash table that many threads can search and insert in at once
+//
+// every bucket has a spin lock, held by the insert or split that writes it, and a generation,
+// bumped only when a split retires its chain; inserts append in place, so a lookup takes no lock at
+// all: it scans the chain and retries if the generation changed meanwhile
+// splits are made one at a time and lock only the bucket being split and the new one, so inserts
+// and lookups at every other bucket carry on; the buckets of a retired chain are reused by later
+// chains but never freed before the table is destroyed, so a lookup racing with a split never reads freed memory
+
+// concurrent hash table handle - abstraction
+typedef struct _concurrent_hash* concurrent_hash;
+
+// create concurrent hash table
+// input: <initial number of buckets>, <bucket size>, <hash function>
+// returns NULL if no hash function was given
+concurrent_hash chash_create(const size_t, const size_t, const HashFunc);
+
+// set when the hash table splits its buckets, only the split load is used
+// not safe to call while other threads use the table
+void chash_set_policy(const concurrent_hash, const split_policy*);
+
+// insert value at the hash table, safe to call from many threads at once
+// returns true if the operation was successful, false if the key exists
+bool chash_insert(const concurrent_hash, const data_t);
+
+// search the hash table and return the element with the key, NULL if not found
+// safe to call from many threads at once, never takes a lock
+data_t chash_search(const concurrent_hash, const value_t);
+
+// get the number of elements currently inserted in the hash table
+size_t chash_size(const concurrent_hash);
+
+// get the number of buckets currently in use
+size_t chash_buckets(const concurrent_hash);
+
+// destroy memory used by the hash table, once no thread uses it
+// and return the number of bytes destroyed
+size_t chash_destroy(const concurrent_hash);
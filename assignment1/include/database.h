@@ -1,9 +1,21 @@
 #pragma once
 
 #include "types.h"
+#include "pin_index.h"
 
-// creates the database
-database db_create(const size_t, const size_t, const int);
+// creates the database, that takes over the voter pool and the string arena of the participants
+// input: <bucket size>, <starting capacity>, <expand function>, <hash function>, <voter pool>, <string arena>
+// the hash function must be supported by the machine, see hash_function
+database db_create(const size_t, const size_t, const int, const int, const voter_pool, const string_arena);
+
+// loads the database from a snapshot, see snapshot.h
+// input: <snapshot file>, <expand function>
+// returns NULL if the snapshot could not be loaded
+database db_load(const char*, const int);
+
+// saves the database at a snapshot
+// returns false if it could not be saved
+bool db_save(const database, const char*);
 
 // closes the database
 size_t db_close(const database);
@@ -12,19 +24,60 @@ size_t db_close(const database);
 bool db_insert(const database, const voter);
 
 // mark the voter as voted
+// the vote is journaled
 void db_insert_voter(const database, const voter);
 
 // mark voter with the specified id as voted
+// the vote is journaled
 bool db_mark_voted(const database, const int);
 
+// remove the participant with the pin, along with its vote
+// the removal is journaled
+// returns false if there is no participant with the pin
+bool db_remove(const database, const int);
+
+// search for the participant with the pin, NULL if there is none
+// the hash function of the table is inlined
+voter db_search(const database, const int);
+
+// search for many participants at once, setting the participant of every pin (NULL if there is none)
+void db_search_many(const database, const int*, const size_t, voter*);
+
+// get the name of a participant
+const char* voter_name(const database, const voter);
+
+// get the surname of a participant
+const char* voter_surname(const database, const voter);
+
 // get the number of participants
 size_t get_participants_size(const database);
 
 // get the number of voters
 size_t get_voters_size(const database);
 
-// sort the voters in the database
-void db_sort(const database);
+// count the participants & the voters with pins from the first to the second, both included
+// input: <database>, <first pin>, <last pin>, <participants counted>, <voters counted>
+void db_count_range(const database, const int, const int, size_t*, size_t*);
+
+// visit the participants with pins from the first to the second, both included, in ascending order of pins
+// input: <database>, <first pin>, <last pin>, <function given every participant>, <its argument>
+void db_range(const database, const int, const int, const RangeFunc, void*);
+
+// count the participants & the voters that reside in the zipcode
+// input: <database>, <zipcode>, <participants counted>, <voters counted>
+void db_count_zip(const database, const int, size_t*, size_t*);
 
 // insert participant in the db
 bool db_participant_insert(const database, const voter);
+
+// create a participant, storing its names at the database, and insert it
+// the insertion is journaled
+// input: <database>, <pin>, <surname>, <name>, <zipcode>
+// returns false if a participant with the pin exists
+bool db_add_participant(const database, const int, const char*, const char*, const int);
+
+// insert an array of participants in the db at once
+// the participants are radix sorted by pin, so duplicates are found in a single pass and destroyed
+// (only the first participant read with a pin is kept)
+// returns the number of participants inserted
+size_t db_bulk_insert(const database, voter*, const size_t);
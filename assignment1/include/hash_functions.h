@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string.h>
+#include <stdbool.h>
+#include "linear_hashing.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define HAVE_CRC32C 1
+#endif
+
+// the hash functions a database can use, selected with -h
+typedef enum
+{
+    HASH_IDENTITY = 0,  // the pin itself, as in the paper on the K22 site
+    HASH_FIBONACCI,     // multiplicative hashing by the golden ratio
+    HASH_MURMUR,        // the finalizer of murmur3
+    HASH_CRC32C,        // the crc32c instruction of SSE4.2
+    HASH_FUNCS_NUM
+}
+hash_kind;
+
+// the default hash function of the paper on the K22 site
+static inline hash_t hash_identity(int val) { return (hash_t)val; }
+
+// the high half of the product with 2^64 / golden ratio, where every bit of the pin has been mixed in
+static inline hash_t hash_fibonacci(int val)
+{
+    return (hash_t)(((uint64_t)(uint32_t)val * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// the 32-bit finalizer of murmur3, every bit of the pin affects every bit of the hash
+static inline hash_t hash_murmur(int val)
+{
+    uint32_t x = (uint32_t)val;
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+#if defined(HAVE_CRC32C)
+// a single crc32c instruction, only to be used if the cpu supports SSE4.2
+__attribute__((target("sse4.2"))) static inline hash_t hash_crc32c(int val)
+{
+    return _mm_crc32_u32(0xFFFFFFFFu, (uint32_t)val);
+}
+#endif
+
+// returns the hash function of the kind, NULL if it is not supported by this machine
+static inline HashFunc hash_function(const hash_kind kind)
+{
+    switch (kind)
+    {
+        case HASH_IDENTITY: return hash_identity;
+        case HASH_FIBONACCI: return hash_fibonacci;
+        case HASH_MURMUR: return hash_murmur;
+#if defined(HAVE_CRC32C)
+        case HASH_CRC32C: return __builtin_cpu_supports("sse4.2")? hash_crc32c: NULL;
+#endif
+        default: return NULL;
+    }
+}
+
+// returns the kind of hash function with the name, HASH_FUNCS_NUM if there is none
+static inline hash_kind hash_kind_of(const char* name)
+{
+    // the names given to -h, in the order of hash_kind
+    static const char* const names[HASH_FUNCS_NUM] = { "identity", "fibonacci", "murmur", "crc32c" };
+
+    for (int i = 0; i < HASH_FUNCS_NUM; i++)
+        if (strcmp(name, names[i]) == 0) return (hash_kind)i;
+    return HASH_FUNCS_NUM;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "types.h"
+
+// the maximum number of threads that can parse the voters file
+#define MAX_INGEST_THREADS 64
+
+// the least number of bytes a thread parses, smaller files use fewer threads
+#define MIN_INGEST_CHUNK (1 << 16)
+
+// reads the voters file, splitting it at line boundaries into chunks that are parsed by
+// the given number of threads
+// the voters are stored at the pool and their names at the string arena
+// returns the voters in the order they appear in the file and sets their number,
+// NULL if the file could not be opened
+voter* ingest_file(const char* file_name, const int threads, const voter_pool, const string_arena, size_t* voters_num);
+
+
+// the fixed-width binary records of a voter, as written by assignment2
+struct _voter_record
+{
+    int AM;             // pin
+    char surname[20];   // null-terminated, unless it fills the field
+    char name[20];      // null-terminated, unless it fills the field
+    char zipcode[6];    // null-terminated digits, unless they fill the field
+};
+
+// maps the file of binary voter records and adopts the mapping at the string arena, so the names of the voters
+// are read where they are in the file, without being copied (names that fill their field are copied)
+// records with a negative pin, an empty name or a malformed zipcode are skipped
+// the mapping is set along with its size, it has to stay mapped as long as the voters do (NULL if the file is empty)
+// returns the voters in the order they appear in the file and sets their number,
+// NULL if the file could not be mapped
+voter* ingest_records(const char* file_name, const voter_pool, const string_arena, size_t* voters_num, void** mapping, size_t* mapping_size);
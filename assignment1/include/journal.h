@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include "types.h"
+
+// the default number of records that are made durable together
+#define JOURNAL_DEFAULT_BATCH 64
+
+// the default number of microseconds a record waits at most before being made durable
+#define JOURNAL_DEFAULT_INTERVAL 1000
+
+// the starting capacity of the buffers records are gathered in
+#define JOURNAL_BUFFER_START 4096
+
+
+// append-only journal of the votes, insertions & removals, made durable with group commit:
+// records are gathered in memory and written with a single fdatasync once a batch of them
+// is pending, or once the oldest of them has waited for the given interval
+
+// journal handle - abstraction
+typedef struct _journal* journal;
+
+// opens the journal at the file for appending
+// input: <file>, <records per batch>, <interval in microseconds, 0 to only sync full batches>
+// returns NULL if the file could not be opened
+journal journal_open(const char*, const size_t, const long);
+
+// appends a vote
+void journal_vote(const journal, const int);
+
+// appends a removal of a participant
+void journal_remove(const journal, const int);
+
+// appends an insertion of a participant
+// input: <journal>, <pin>, <surname>, <name>, <zipcode>
+void journal_insert(const journal, const int, const char*, const char*, const int);
+
+// makes every record appended so far durable
+void journal_commit(const journal);
+
+// applies every record of the journal at the file to the database
+// a record cut short by a crash is ignored
+// returns the number of records applied, -1 if the file could not be opened
+long journal_replay(const char*, const database);
+
+// commits the pending records and closes the journal
+// returns the number of bytes destroyed
+size_t journal_close(const journal);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include "types.h"
+#include "split_policy.h"
+#include "output.h"
 
 // value types we need
 typedef unsigned int hash_t;
@@ -12,13 +15,16 @@ typedef struct _voter* data_t;
 // function that hashes a value
 typedef hash_t (*HashFunc)(int value);
 
-// function that takes as input the old size of buckets and outputs the new bucket size
+// function that takes as input the old size of the directory of bucket segments and outputs the new size
 typedef size_t (*ExpandFunc)(size_t value);
 
 
 // hash table handle - abastraction
 typedef struct _linear_hash* hash_table;
 
+// the number of keys hash_search_many has in flight at once
+#define SEARCH_BATCH 16
+
 // how to get the key
 #define get_key(val) (val->PIN)
 
@@ -28,6 +34,13 @@ typedef struct _linear_hash* hash_table;
 // the default expand function
 hash_table hash_create(const size_t, const size_t, const HashFunc, const ExpandFunc);
 
+// get the number of starting buckets needed to hold the given number of elements without splitting
+// input: <number of elements>, <bucket size>, <load factor above which buckets are split>
+size_t hash_presize(const size_t, const size_t, const double);
+
+// set when the hash table splits its buckets, the default being split_policy_default
+void hash_set_policy(const hash_table, const split_policy*);
+
 // get the number of elements currently inserted in the hash table
 size_t hash_size(const hash_table);
 
@@ -35,12 +48,67 @@ size_t hash_size(const hash_table);
 // returns true if the operation was successful, false if not
 bool hash_insert(const hash_table, const data_t);
 
+// insert an array of values at the hash table
+// the values must have unique keys that do not exist in the hash table, no duplicate check is made
+void hash_bulk_insert(const hash_table, const data_t*, const size_t);
+
+// remove the element with the key from the hash table, merging buckets back once the load factor
+// falls below the merge load of the policy
+// returns the element removed, NULL if not found
+data_t hash_remove(const hash_table, const value_t);
+
 // search the hash table and return the element with the key
 // NULL if not found
 data_t hash_search(const hash_table, const value_t);
 
-// print hash table (for debugging purposes)
-void hash_print(const hash_table);
+// search the hash table for many keys at once, setting the element with each key (NULL if not found)
+// the buckets of a batch of keys are brought into the cache together before any of them is searched,
+// so their memory latency overlaps
+// input: <hash table>, <keys>, <number of keys>, <array the elements found are set at>
+void hash_search_many(const hash_table, const value_t*, const size_t, data_t*);
+
+// write the shape of the hash table and the elements of every bucket, which are referred to
+// by their position at the array written by pool_save
+// returns false if writing failed
+bool hash_save(const hash_table, FILE*, const voter_pool);
+
+// create a hash table out of one written by hash_save, its elements being at the given array
+// every element is placed straight at its saved bucket, nothing is hashed
+// input: <saved hash table>, <elements>, <hash function>, <expand function>
+hash_table hash_load(const void*, const data_t, const HashFunc, const ExpandFunc);
+
+// the number of lengths of overflow chains told apart by the statistics, longer chains count as the last one
+#define HASH_CHAIN_LENGTHS 8
+
+// statistics of the hash table
+typedef struct
+{
+    size_t elements;            // the number of elements
+    size_t buckets;             // the number of buckets in use
+    size_t bucket_size;         // the number of elements that fit in a bucket
+    double load_factor;         // elements / capacity of the non-overflow buckets
+    double split_load;          // the load factor above which buckets are split currently
+    size_t splits;              // the number of splits so far
+    size_t merges;              // the number of merges so far
+    size_t directory_reallocs;  // the number of times the directory was reallocated
+    size_t chains[HASH_CHAIN_LENGTHS+1];  // the number of buckets with a chain of every length, 0 being empty
+    size_t hits;                // searches that found their key
+    size_t misses;              // searches that did not
+    double avg_hit_probes;      // the average number of buckets scanned by a hit
+    double avg_miss_probes;     // the average number of buckets scanned by a miss
+    size_t max_hit_probes;      // the most buckets a hit scanned
+    size_t max_miss_probes;     // the most buckets a miss scanned
+    size_t directory_bytes;     // the bytes of the directory
+    size_t segment_bytes;       // the bytes of the segments
+    size_t bucket_bytes;        // the bytes of the slabs the buckets are carved from
+}
+hash_stats;
+
+// fill the statistics of the hash table, visiting every bucket
+void hash_get_stats(const hash_table, hash_stats*);
+
+// print hash table at the buffer (for debugging purposes)
+void hash_print(const hash_table, const out_buffer);
 
 // destroy memory used by the hash table
 // and return the number of bytes destroyed
@@ -0,0 +1,210 @@
+#pragma once
+
+// the layout of the linear hash table and the parts of its lookup that are inlined
+// only the table itself and the lookups specialized with LH_SPECIALIZE should include this
+
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "linear_hashing.h"
+#include "split_policy.h"
+
+// the buckets are reached through a directory of fixed-size segments (Larson's layout),
+// so growing the table only adds a segment and never moves the existing buckets
+#define SEGMENT_SHIFT 8
+#define SEGMENT_SIZE (1 << SEGMENT_SHIFT)
+#define SEGMENT_MASK (SEGMENT_SIZE - 1)
+
+typedef struct _node* node;
+struct _node
+{
+    data_t* data;          // the elements stored in the bucket
+    value_t* keys;         // the keys of the elements, kept inline so a probe never dereferences an element
+    uint32_t number_used;  // number of elements used in the bucket
+    node next_bucket;      // overflow bucket
+};
+
+// a slab of memory that bucket blocks are carved from
+typedef struct _slab* slab;
+struct _slab
+{
+    slab next;    // the previously allocated slab
+    size_t size;  // the bytes of the slab, header included
+};
+
+// every bucket is a fixed-size block: the node header, its elements and then its keys
+struct _bucket_pool
+{
+    slab slabs;          // the slabs allocated so far
+    node free_buckets;   // recycled buckets, linked through next_bucket
+    char* cursor;        // the next block to be carved from the newest slab
+    size_t blocks_left;  // the number of blocks left to carve from the newest slab
+    size_t slab_blocks;  // the number of blocks the next slab will hold
+    size_t block_size;   // the bytes of a block
+    size_t bytes;        // the bytes allocated for slabs
+    size_t used;         // the buckets handed out and not given back, overflow ones included
+};
+
+// the lookups made so far, a probe being a bucket of the chain that was scanned
+struct _lookup_counters
+{
+    size_t hits;             // lookups that found their key
+    size_t misses;           // lookups that did not
+    size_t hit_probes;       // the probes of every hit
+    size_t miss_probes;      // the probes of every miss
+    size_t max_hit_probes;   // the most probes a hit needed
+    size_t max_miss_probes;  // the most probes a miss needed
+};
+
+struct _linear_hash
+{
+    node** segments;       // the directory of segments, each holding SEGMENT_SIZE buckets
+    size_t segments_num;   // the number of segments allocated
+    size_t directory_size; // the number of segments the directory can point to
+    size_t p;              // the next bucket to be split
+    size_t i;              // the exponenent of the hash function
+    size_t elements_num;   // the number of elements stored currently in the hash table
+    size_t curr_capacity;  // the current amount of buckects being used
+    size_t max_capacity;   // the maximum number of buckects that can be used (allocated in segments)
+    size_t capacity;       // the maximum capacity of elements in non-overflow buckets
+    size_t bucket_size;    // the number of elements that can fit in a bucket
+    size_t powi;           // 2^i * m
+    size_t powi_1;         // 2^(i+1) * m
+    HashFunc hash;         // hash function
+    ExpandFunc expand;     // expand function, grows the directory
+    struct _bucket_pool pool;  // the allocator of the buckets
+    split_policy policy;       // when buckets are split
+    size_t splits;             // the number of splits so far
+    size_t merges;             // the number of merges so far
+    size_t min_buckets;        // the buckets the table started with, it never shrinks below them
+    size_t directory_reallocs; // the number of times the directory was reallocated
+    struct _lookup_counters lookups;  // the searches made so far
+};
+
+// get the head of the chain of the bucket at the specified index
+static inline node* bucket_at(const hash_table ht, const size_t index)
+{
+    return &ht->segments[index >> SEGMENT_SHIFT][index & SEGMENT_MASK];
+}
+
+// scan the keys of a bucket for the specified key
+// returns the index of the key in the bucket, -1 if not found
+static inline int bucket_find(const node bucket, const value_t key)
+{
+    const value_t* keys = bucket->keys;
+    const uint32_t used = bucket->number_used;
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    // compare 4 keys at a time
+    const __m128i needle = _mm_set1_epi32(key);
+    for (; i + 4 <= used; i += 4)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(keys + i));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(block, needle));
+        if (mask != 0)  // every matching key sets 4 bits of the mask
+            return i + __builtin_ctz(mask) / 4;
+    }
+#endif
+
+    // compare the remaining keys one by one
+    for (; i < used; i++)
+        if (keys[i] == key) return i;
+
+    return -1;
+}
+
+// search the chain of buckets starting at the given bucket for the specified key
+static inline data_t chain_find(node curr_bucket, const value_t key)
+{
+    for (; curr_bucket != NULL; curr_bucket = curr_bucket->next_bucket)
+    {
+        const int index = bucket_find(curr_bucket, key);
+        if (index != -1)  // key matches
+            return curr_bucket->data[index];
+    }
+    
+    return NULL;
+}
+
+// search the chain like chain_find, counting the lookup at the table
+static inline data_t chain_lookup(const hash_table ht, node curr_bucket, const value_t key)
+{
+    data_t found = NULL;
+    size_t probes = 0;
+    for (; curr_bucket != NULL; curr_bucket = curr_bucket->next_bucket)
+    {
+        probes++;
+        const int index = bucket_find(curr_bucket, key);
+        if (index != -1)  // key matches
+        {
+            found = curr_bucket->data[index];
+            break;
+        }
+    }
+
+    struct _lookup_counters* lookups = &ht->lookups;
+    if (found != NULL)
+    {
+        lookups->hits++;
+        lookups->hit_probes += probes;
+        if (probes > lookups->max_hit_probes) lookups->max_hit_probes = probes;
+    }
+    else
+    {
+        lookups->misses++;
+        lookups->miss_probes += probes;
+        if (probes > lookups->max_miss_probes) lookups->max_miss_probes = probes;
+    }
+    return found;
+}
+
+// defines <name>_bucket, <name>_search and <name>_search_many: the bucket of a key, hash_search and
+// hash_search_many with the hash function HASH (a function or a macro taking the key) inlined instead
+// of called through the pointer of the table, that must have been created with the same hash function
+// ATTRIBUTES are added to all of them, for hash functions that need a target of their own
+#define LH_SPECIALIZE(name, HASH, ATTRIBUTES)                                                     \
+    /* h_1, or h_2 if the bucket of h_1 has been split */                                        \
+    ATTRIBUTES static inline hash_t name##_bucket(const hash_table ht, const value_t key)        \
+    {                                                                                            \
+        const hash_t hash = HASH(key);                                                           \
+        const hash_t h_1 = hash % ht->powi;                                                      \
+        return (h_1 < ht->p? hash % ht->powi_1: h_1);                                            \
+    }                                                                                            \
+                                                                                                 \
+    ATTRIBUTES static inline data_t name##_search(const hash_table ht, const value_t key)         \
+    {                                                                                            \
+        return chain_lookup(ht, *bucket_at(ht, name##_bucket(ht, key)), key);                    \
+    }                                                                                            \
+                                                                                                 \
+    ATTRIBUTES static inline void name##_search_many(const hash_table ht, const value_t* keys,   \
+                                                     const size_t n, data_t* found)              \
+    {                                                                                            \
+        node* slots[SEARCH_BATCH];                                                               \
+        node heads[SEARCH_BATCH];                                                                \
+        for (size_t start = 0; start < n; start += SEARCH_BATCH)                                 \
+        {                                                                                        \
+            const size_t batch = (n - start < SEARCH_BATCH)? n - start: SEARCH_BATCH;            \
+                                                                                                 \
+            /* find the directory slot of every key and start bringing them to the cache */      \
+            for (size_t i = 0; i < batch; i++)                                                   \
+            {                                                                                    \
+                slots[i] = bucket_at(ht, name##_bucket(ht, keys[start + i]));                    \
+                __builtin_prefetch(slots[i]);                                                    \
+            }                                                                                    \
+                                                                                                 \
+            /* then the heads of the buckets and their keys */                                   \
+            for (size_t i = 0; i < batch; i++)                                                   \
+            {                                                                                    \
+                heads[i] = *slots[i];                                                            \
+                if (heads[i] != NULL) __builtin_prefetch(heads[i]);                              \
+            }                                                                                    \
+            for (size_t i = 0; i < batch; i++)                                                   \
+                if (heads[i] != NULL) __builtin_prefetch(heads[i]->keys);                        \
+                                                                                                 \
+            /* by now most of the memory the searches need has arrived */                       \
+            for (size_t i = 0; i < batch; i++)                                                   \
+                found[start + i] = chain_lookup(ht, heads[i], keys[start + i]);                  \
+        }                                                                                        \
+    }
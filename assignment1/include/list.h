@@ -3,6 +3,9 @@
 #include "../include/types.h"
 #include <stdbool.h>
 
+// the first chunk of a list holds 1 << LIST_FIRST_SHIFT values, every next chunk twice as many as the previous one
+#define LIST_FIRST_SHIFT 2
+
 
 // pointer to function that destroys an element value and returns the bytes freed by it
 typedef size_t (*DestroyFunc)(void* value);
@@ -13,35 +16,35 @@ typedef int (*CompareFunc)(void* a, void* b);
 // list handle - abstraction
 typedef struct listSet* List;
 
+// The values are stored in order at contiguous chunks, each twice the size of the previous one,
+// so growing never moves the values already stored and the position of a value is found in O(1)
+
 // General functions:
 
 // creates a list
 List list_create(const DestroyFunc);
 
-// pushes value at the top of the list
+// pushes value at the end of the list
 void list_push(const List, void*);
 
 // returns the size of the list
 size_t list_size(const List);
 
-// returns the value at the top of the list
+// returns the value at the position, the first value pushed being at 0
+void* list_get(const List, const size_t);
+
+// returns the value pushed last
 void* list_top_value(const List);
 
-// sorts the list using merge sort
+// removes the value at the position, the values after it move one position back
+void list_remove_at(const List, const size_t);
+
+// sorts the list using bottom-up merge sort, values that compare equal keep their order
 void list_sort(const List, const CompareFunc);
 
+// returns the number of bytes used by the list, the values excluded
+size_t list_bytes(const List);
+
 // destroys the memory used by the list
 // and return the number of bytes destroyed
 size_t list_destroy(const List);
-
-
-// Custom functions used for the commands:
-
-// custom function that inserts a voter on our 2d list
-void list_insert_postcode(const List list, const voter);
-
-// print all participants with the specified zip
-void print_zipcodes(const List, const int);
-
-// print the list
-void sorted_print(const List);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+
+// the default capacity of an output buffer
+#define OUT_BUFFER_SIZE (1 << 16)
+
+
+// buffer that gathers output and writes it to its stream with as few writes as possible
+// a buffer with no stream keeps growing instead, until its output is taken with out_data & out_consume
+
+// output buffer handle - abstraction
+typedef struct _out_buffer* out_buffer;
+
+// creates an output buffer of the given capacity that writes to the stream, NULL for none
+out_buffer out_create(FILE*, const size_t);
+
+// appends the first n characters of the string
+void out_write(const out_buffer, const char*, const size_t);
+
+// appends a null-terminated string
+void out_string(const out_buffer, const char*);
+
+// appends an integer
+void out_int(const out_buffer, const long);
+
+// appends formatted output, like printf
+void out_printf(const out_buffer, const char*, ...) __attribute__((format(printf, 2, 3)));
+
+// writes everything gathered so far to the stream
+void out_flush(const out_buffer);
+
+// the output gathered so far
+const char* out_data(const out_buffer);
+
+// the number of characters gathered so far
+size_t out_size(const out_buffer);
+
+// drops the first n characters gathered, once they were written elsewhere
+void out_consume(const out_buffer, const size_t);
+
+// flushes and destroys the buffer
+// and returns the number of bytes destroyed
+size_t out_destroy(const out_buffer);
+
+
+// the buffers the commands write their responses & their errors at
+// they write to stdout & stderr, unless redirected to the buffers of a client
+out_buffer responses(void);
+out_buffer errors(void);
+
+// redirects the responses & errors to the given buffers, NULL to go back to stdout & stderr
+void out_redirect(const out_buffer, const out_buffer);
+
+// hands the responses & errors gathered over to stdout & stderr, without flushing them
+void out_flush_std(void);
+
+// flushes and destroys the buffers of stdout & stderr
+// and returns the number of bytes destroyed
+size_t out_close_std(void);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "types.h"
+
+// the pins of a block are 2^BITMAP_BLOCK_BITS consecutive ones, a block being a cache line of bits
+#define BITMAP_BLOCK_BITS 9
+
+// the starting number of slots of the block map, always a power of 2
+#define BITMAP_START_SLOTS 64
+
+
+// bitmap over the whole range of pins, a bit per pin
+// only the blocks with a pin that was set exist, found through an open addressing map of their first pins,
+// so the memory follows the number of blocks set and not how far apart their pins are
+// a range is counted block by block, or over every block if that is less, with the popcount instruction
+// where the machine has one
+
+// pin bitmap handle - abstraction
+typedef struct _pin_bitmap* pin_bitmap;
+
+// creates an empty bitmap
+pin_bitmap bitmap_create(void);
+
+// sets the bit of the pin, returns false if it was already set
+bool bitmap_set(const pin_bitmap, const int);
+
+// clears the bit of the pin, returns false if it was not set
+bool bitmap_clear(const pin_bitmap, const int);
+
+// returns true if the bit of the pin is set
+bool bitmap_test(const pin_bitmap, const int);
+
+// returns the number of pins set
+size_t bitmap_count(const pin_bitmap);
+
+// returns the number of pins set from the first pin to the second, both included
+size_t bitmap_count_range(const pin_bitmap, const int, const int);
+
+// writes the bitmap, its blocks & its map as they are
+// returns false if writing failed
+bool bitmap_save(const pin_bitmap, FILE*);
+
+// creates a bitmap out of one written by bitmap_save
+pin_bitmap bitmap_load(const void*);
+
+// returns the number of bytes used by the bitmap
+size_t bitmap_bytes(const pin_bitmap);
+
+// destroys the memory used by the bitmap
+// and returns the number of bytes destroyed
+size_t bitmap_destroy(const pin_bitmap);
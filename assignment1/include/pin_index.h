@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "types.h"
+
+// the most pins a node of the index holds, a leaf being a few cache lines of pins
+#define PIN_NODE_KEYS 64
+
+// the starting capacity of the participants inserted since the last query
+#define PIN_PENDING_START 1024
+
+
+// ordered index of the participants by pin, a b+tree of wide nodes whose leaves are linked in order
+// inserts are gathered and sorted, then moved to the tree together once it is queried, so loading the participants
+// one by one builds it at once and later inserts reach it in order of pin
+// removals only take the pin out of its leaf, nodes are never merged back
+
+// pin index handle - abstraction
+typedef struct _pin_index* pin_index;
+
+// function that is given the participants of a range in order, along with an argument of the caller
+typedef void (*RangeFunc)(const voter, void*);
+
+// creates an empty index
+pin_index pindex_create(void);
+
+// inserts the participant, whose pin must not be in the index already
+void pindex_insert(const pin_index, const voter);
+
+// removes the participant with the pin
+// returns false if there is none
+bool pindex_remove(const pin_index, const int);
+
+// calls the function for every participant with a pin from the first to the second, both included,
+// in ascending order of pins
+void pindex_range(const pin_index, const int, const int, const RangeFunc, void*);
+
+// returns the number of participants
+size_t pindex_size(const pin_index);
+
+// writes the participants of the index in order of pin, referred to by their position at the array written by pool_save
+// returns false if writing failed
+bool pindex_save(const pin_index, FILE*, const voter_pool);
+
+// creates an index out of one written by pindex_save, its participants being at the given array
+// the leaves are filled in order, the tree is built on top of them
+pin_index pindex_load(const void*, const voter);
+
+// returns the number of bytes used by the index
+size_t pindex_bytes(const pin_index);
+
+// destroys the memory used by the index
+// and returns the number of bytes destroyed
+size_t pindex_destroy(const pin_index);
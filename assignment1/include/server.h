@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+#include "types.h"
+
+// the number of events taken from epoll at once
+#define SERVER_EVENTS 64
+
+// the bytes of a client read at once, lines longer than a command buffer are reported as malformed
+#define SERVER_READ_SIZE 4096
+
+// the bytes of responses a client can leave unread before the server stops reading its commands
+#define SERVER_OUT_LIMIT (1 << 24)
+
+// the number of clients that can wait to be accepted
+#define SERVER_BACKLOG 128
+
+
+// serves the database to the clients of a unix domain socket, all of them from a single epoll loop
+// a client sends lines of commands, as many as it wants without waiting for their responses,
+// and gets back the responses & errors of every command in order, like a terminal would show them
+// l, i, m, d, bv, v, perc, z, o, r & rperc are served, exit closes the connection of the client
+// runs until SIGINT or SIGTERM
+// input: <database>, <path of the socket>
+// returns false if the socket could not be set up
+bool server_run(const database, const char*);
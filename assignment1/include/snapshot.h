@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include "types.h"
+#include "linear_hashing.h"
+
+// the first bytes of every snapshot
+#define SNAPSHOT_MAGIC "MVOTESNP"
+
+// the version of the layout of the snapshot, changes whenever the layout does
+#define SNAPSHOT_VERSION 4
+
+// every section of the snapshot starts at a multiple of this
+#define SNAPSHOT_ALIGNMENT 64
+
+// the suffix of the temporary file a snapshot is written at before it replaces the old one, completed by mkstemp
+#define SNAPSHOT_TMP_SUFFIX ".XXXXXX"
+
+
+// a snapshot is a binary image of the database: a header followed by the voters, the string pages,
+// the buckets of the hash table, the zipcode index, the bitmaps of the participants & the voters
+// and the ordered index, each referring to the voters by their position
+// it is loaded with a single mmap, the voters and the strings are used straight from the mapping
+
+// writes the database at a temporary file next to the file, then renames it over the file
+// so saving over the snapshot the database was loaded from is safe, and a failed save leaves the old file as it was
+// returns false if the file could not be written
+bool snapshot_save(const database, const char*);
+
+// maps the snapshot at the file and restores the database from it
+// the mapping is released when the database closes
+// the table keeps the hash function it was saved with
+// returns false if the file could not be opened, is not a snapshot of this version
+// or its hash function is not supported by this machine
+bool snapshot_load(const database, const char*, const ExpandFunc);
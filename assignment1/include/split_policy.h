@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// the load factor above which a bucket is split, as in the paper
+#define SPLIT_DEFAULT_LOAD 0.75
+
+// the range the adaptive policy keeps the split load factor in, and how far it moves it at a time
+#define SPLIT_MIN_LOAD 0.25
+#define SPLIT_MAX_LOAD 2.0
+#define SPLIT_ADAPT_STEP 0.05
+
+// the number of inserts between two adaptations of the split load factor
+#define SPLIT_ADAPT_PERIOD 1024
+
+
+// when a linear hash table splits buckets and when it merges them back, shared by the tables of assignment1 and assignment4
+// the load factor is the number of elements over the capacity of the non-overflow buckets
+typedef struct
+{
+    double split_load;    // split once the load factor exceeds it
+    double merge_load;    // merge once the load factor falls below it, 0 never merges
+    size_t max_splits;    // the most buckets a single insert splits, more than 1 lets bulk loads catch up
+    double target_chain;  // the average buckets per chain the split load adapts to, 0 keeps it fixed
+    size_t inserts;       // the inserts since the last adaptation
+}
+split_policy;
+
+// the policy of the paper: split a single bucket once the load factor exceeds 0.75, never merge
+static inline split_policy split_policy_default(void)
+{
+    return (split_policy){ SPLIT_DEFAULT_LOAD, 0, 1, 0, 0 };
+}
+
+// returns the number of buckets to split for the load factor to fall back to the split load,
+// at most max_splits of them
+// input: <policy>, <elements>, <capacity of the non-overflow buckets>, <bucket size>
+static inline size_t split_policy_splits(const split_policy* policy, const size_t elements, const size_t capacity, const size_t bucket_size)
+{
+    if ((double)elements <= policy->split_load * capacity) return 0;
+
+    // every split adds the capacity of a bucket
+    const double missing = (double)elements / policy->split_load - capacity;
+    const size_t splits = (size_t)(missing / bucket_size) + 1;
+    return (splits < policy->max_splits)? splits: policy->max_splits;
+}
+
+// returns true if the last split should be undone, as the load factor fell below the merge load
+// the table never shrinks below the buckets it started with
+// input: <policy>, <elements>, <capacity of the non-overflow buckets>, <buckets in use>, <starting buckets>
+static inline bool split_policy_merge(const split_policy* policy, const size_t elements, const size_t capacity, const size_t buckets, const size_t min_buckets)
+{
+    return buckets > min_buckets && (double)elements < policy->merge_load * capacity;
+}
+
+// called after every insert with the buckets allocated, overflow ones included, and the buckets in use
+// every SPLIT_ADAPT_PERIOD inserts the split load moves a step towards the one that gives the target chain length,
+// never below twice the merge load
+static inline void split_policy_adapt(split_policy* policy, const size_t allocated, const size_t buckets)
+{
+    if (policy->target_chain <= 0 || ++policy->inserts < SPLIT_ADAPT_PERIOD) return;
+    policy->inserts = 0;
+
+    // the split load stays at least twice the merge load, so a bucket just split is not merged right back
+    const double min_load = (2 * policy->merge_load > SPLIT_MIN_LOAD)? 2 * policy->merge_load: SPLIT_MIN_LOAD;
+
+    const double chain = (double)allocated / buckets;
+    if (chain > policy->target_chain && policy->split_load - SPLIT_ADAPT_STEP >= min_load)
+        policy->split_load -= SPLIT_ADAPT_STEP;  // chains too long, spend memory on buckets
+    else if (chain < policy->target_chain && policy->split_load + SPLIT_ADAPT_STEP <= SPLIT_MAX_LOAD)
+        policy->split_load += SPLIT_ADAPT_STEP;  // chains shorter than needed, save the memory
+}
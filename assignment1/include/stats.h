@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdbool.h>
+#include "types.h"
+#include "output.h"
+
+// prints the statistics of the database at the buffer: the shape of the hash table, the lengths of its chains,
+// the probes of its lookups and the bytes of every component
+void stats_print(const database, const out_buffer);
+
+// writes the same statistics at the file as a json object
+// returns false if the file could not be written
+bool stats_write_json(const database, const char*);
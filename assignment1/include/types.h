@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+
 // input buffer sizes
 #define BUFFER_SIZE 800
 #define LINE_SIZE 800
@@ -13,34 +16,67 @@
 // default expand function of the hash table
 #define DEFAULT_EXPAND_FUNC 1
 
+// by default buckets are merged back once the load factor falls to a third of the split load
+#define DEFAULT_MERGE_DIVISOR 3
+
+// default hash function of the hash table, see hash_functions.h
+#define DEFAULT_HASH_FUNC 0
+
+// the maximum number of pins a single l or m command can be given
+#define MAX_COMMAND_PINS (LINE_SIZE / 2)
+
+// starting capacity of the array the voters are gathered in at bulk mode
+#define DEFAULT_BULK_CAPACITY 1024
+
 
 typedef struct _linear_hash* hash_table;
+typedef struct _zip_index* zip_index;
+typedef struct _string_arena* string_arena;
+typedef struct _voter_pool* voter_pool;
+typedef struct _journal* journal;
+typedef struct _pin_bitmap* pin_bitmap;
+typedef struct _pin_index* pin_index;
 typedef struct listSet* List;
 
 struct _voter
 {
-    int PIN;        // pin
-    char* name;     // name
-    char* surname;  // surname
-    int TK;         // postcode
-    char voted;     // voted(y/n)
+    int PIN;           // pin
+    int TK;            // postcode
+    uint32_t name;     // offset of the name in the string arena
+    uint32_t surname;  // offset of the surname in the string arena
+    char voted;        // voted(y/n)
 };
 typedef struct _voter* voter;
 
 struct _database
 {
     hash_table ht;      // main data structure holding all participants and voters
-    List list;          // list containing the voters
+    int hash_func;      // the kind of hash function of the table
+    zip_index zips;     // index of the zipcodes, along with the voters of each
+    voter_pool voters;  // the memory of every participant
+    string_arena strings;  // the names & surnames of every participant
     size_t voters_num;  // the total number of participants
-    int sorted;         // is the list with the zipcodes sorted
+    void* snapshot;       // the snapshot the database was loaded from, NULL if none
+    size_t snapshot_size; // the size of the snapshot mapping
+    void* records;        // the binary records the names of some participants live in, NULL if none
+    size_t records_size;  // the size of the records mapping
+    journal log;          // where the votes & insertions are journaled, NULL if they are not
+    pin_bitmap registered;  // the pins of the participants
+    pin_bitmap voted;       // the pins of the voters
+    pin_index ordered;      // the participants in order of pin
+    const char* stats_file;  // where the statistics are written at exit, NULL if they are not
+    const char* listen_path; // the unix socket clients are served at, NULL to read commands from stdin
+    bool batch;              // commands are read from stdin in blocks, see batch.h
 };
 typedef struct _database* database;  // handle
 
-// 1d list containing every zipcode along with every voter that resides in it
+// a zipcode of the index along with every voter that resides in it
 struct _postcode_info
 {
-    int postcode;  // postcode
-    List voters;   // list of the voters with the specified postcode
+    int postcode;       // postcode
+    List voters;        // the voters with the specified postcode, in the order they voted
+    size_t participants;  // the number of participants that reside in it, voters or not
+    size_t rank;        // the position of the zipcode in the ranking of the index
 };
 typedef struct _postcode_info* postcode;
 
@@ -56,6 +92,14 @@ typedef enum
     TK_VOTERS,     // 8
     EXIT,          // 9
     PRINT,         // 10 - mine
-    UNRECOGNIZED
+    SAVE,          // 11 - save <file>
+    STATS,         // 12 - stats
+    DELETE,        // 13 - d <pin>
+    RANGE,         // 14 - r <first pin> <last pin>
+    RANGE_PER,     // 15 - rperc <first pin> <last pin>
+    TOP,           // 16 - top <k> [perc]
+    ZIP_TURNOUT,   // 17 - zt [<min percentage> [<max percentage>]]
+    UNRECOGNIZED,
+    NO_COMMAND     // an empty line, already reported
 }
 command_t;
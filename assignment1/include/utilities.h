@@ -3,6 +3,8 @@
 #include "types.h"
 #include "linear_hashing.h"
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 // gets commands and returns the assigned mapped value
 char command_num(char*);
@@ -20,23 +22,51 @@ void command_preprocess(char*);
 // returns -1 if not an integer
 int string_to_int(const char*);
 
-// creates voter
-// input: <first name>  <last name> <ID> <zipcode>
-voter create_voter(char*, char*, const int, const int);
+// gets as input a string and returns an equivalent floating point number
+// returns -1 if not a number
+double string_to_double(const char*);
+
+// same as string_to_int, for the first n characters of the string
+int string_n_to_int(const char*, const size_t);
+
+// maps the whole file in memory, for reading
+// returns NULL if the file could not be opened and sets its size
+const char* map_file(const char*, size_t*);
+
+// unmaps a file mapped by map_file
+void unmap_file(const char*, const size_t);
+
+// creates voter at the pool
+// input: <pool>, <first name offset>, <last name offset>, <ID>, <zipcode>
+// the names are offsets of strings already stored at the string arena
+voter create_voter(const voter_pool, const uint32_t, const uint32_t, const int, const int);
 
 // returns a copy of the given string
 char* mystrcpy(const char*);
 
+// returns a copy of the first n characters of the given string
+char* mystrncpy(const char*, const size_t);
+
 // opens command line arguments and creates the database
 // returns NULL if an error occured while parsing the arguments
 database open_cmd(int argc, char* argv[]);
 
-// a compare function needed for the list sort
-int comp_list(void*, void*);
-
 // pint malformed input error and return false if the string is NULL
 bool check_malformed(const char*);
 
+// a participant along with its pin, mapped so that unsigned order is the signed order of the pins
+typedef struct
+{
+    uint32_t key;
+    voter v;
+}
+pin_entry;
+
+// sort the entries by key with a stable lsd radix sort, one byte per pass
+// being stable, participants with the same pin stay in the order they were read
+// the sorted entries end up at either of the two arrays, which are swapped accordingly
+void radix_sort(pin_entry**, pin_entry**, const size_t);
+
 // wraps the standard malloc and checks if the allocation failed
 static inline void* custom_malloc(const size_t alloc_size)
 {
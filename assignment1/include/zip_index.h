@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "types.h"
+#include "output.h"
+
+// the starting number of slots of the zipcode map, always a power of 2
+#define ZIP_MAP_START_SLOTS 64
+
+// the starting capacity of the first ranked positions, one for every number of voters
+#define ZIP_VOTERS_START 4
+
+
+// zipcode index handle - abstraction
+typedef struct _zip_index* zip_index;
+
+// creates a zipcode index
+zip_index zip_create(void);
+
+// inserts the voter at the array of its zipcode
+void zip_insert(const zip_index, const voter);
+
+// removes the voter from the array of its zipcode, keeping the order of the rest
+// returns false if the voter is not in it
+bool zip_remove(const zip_index, const voter);
+
+// counts one more participant that resides in the zipcode
+void zip_register(const zip_index, const int);
+
+// counts one less participant that resides in the zipcode
+void zip_unregister(const zip_index, const int);
+
+// returns the info of the zipcode, NULL if no participant resides in it
+postcode zip_find(const zip_index, const int);
+
+// returns the number of zipcodes with participants
+size_t zip_size(const zip_index);
+
+// print all voters with the specified zip at the buffer
+void zip_print(const zip_index, const int, const out_buffer);
+
+// print every zipcode along with its number of voters, in descending order of voters
+// the ranking is kept up to date by every insert, so no sorting takes place
+void zip_print_ranked(const zip_index, const out_buffer);
+
+// print the given number of zipcodes with the most voters, as zip_print_ranked does - O(k)
+void zip_print_top(const zip_index, const size_t, const out_buffer);
+
+// print the given number of zipcodes with the highest turnout among their participants, along with it
+// they are kept at a heap of that many zipcodes while every zipcode is visited - O(zipcodes * log k)
+void zip_print_top_turnout(const zip_index, const size_t, const out_buffer);
+
+// print the turnout of every zipcode with participants whose percentage of voters is from the first to the second one,
+// in descending order of voters
+void zip_print_turnout(const zip_index, const double, const double, const out_buffer);
+
+// writes the index, its voters referred to by their position at the array written by pool_save
+// returns false if writing failed
+bool zip_save(const zip_index, FILE*, const voter_pool);
+
+// creates an index out of one written by zip_save, its voters being at the given array
+zip_index zip_load(const void*, const voter);
+
+// returns the number of bytes used by the index
+size_t zip_bytes(const zip_index);
+
+// destroys the memory used by the index
+// and returns the number of bytes destroyed
+size_t zip_destroy(const zip_index);
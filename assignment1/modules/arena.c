@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/arena.h"
+#include "../include/utilities.h"
+
+// offsets are 32-bit, so at most this many pages can be addressed
+#define ARENA_MAX_PAGES ((1u << (32 - ARENA_PAGE_SHIFT)) - 1)
+
+#define ARENA_PAGE_MASK (ARENA_PAGE_SIZE - 1)
+
+// a block of memory that holds one or more consecutive pages
+typedef struct
+{
+    char* memory;  // the memory of the region
+    size_t bytes;  // the number of bytes of the region
+    bool adopted;  // the memory belongs to someone else and is not freed
+}
+arena_region;
+
+struct _string_arena
+{
+    char** pages;              // the start of every page, consecutive pages of a region are contiguous
+    size_t pages_num;          // the number of pages
+    size_t pages_capacity;     // the capacity of the pages array
+    arena_region* regions;     // the memory the pages live in
+    size_t regions_num;        // the number of regions
+    size_t regions_capacity;   // the capacity of the regions array
+    size_t current;            // the page strings are appended at
+    size_t used;               // the bytes used from the start of the current page
+    size_t limit;              // the bytes that can be used from the start of the current page
+};
+
+// grows an array to fit at least the given number of elements
+static void* grow_array(void* array, size_t* capacity, const size_t needed, const size_t element_size)
+{
+    if (needed <= *capacity) return array;
+
+    size_t new_capacity = (*capacity == 0)? 16: *capacity;
+    while (new_capacity < needed) new_capacity *= 2;
+
+    array = realloc(array, new_capacity * element_size);
+    if (array == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed. Exiting..\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = new_capacity;
+    return array;
+}
+
+string_arena arena_create(void)
+{
+    return custom_calloc(1, sizeof(struct _string_arena));
+}
+
+// adds a region of the given bytes as consecutive pages and returns the index of its first page
+static size_t arena_add_region(const string_arena arena, char* memory, const size_t bytes, const bool adopted)
+{
+    const size_t pages = (bytes + ARENA_PAGE_MASK) >> ARENA_PAGE_SHIFT;
+    if (arena->pages_num + pages > ARENA_MAX_PAGES)
+    {
+        fprintf(stderr, "String arena is full. Exiting..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    arena->regions = grow_array(arena->regions, &arena->regions_capacity, arena->regions_num+1, sizeof(*arena->regions));
+    arena->regions[arena->regions_num].memory = memory;
+    arena->regions[arena->regions_num].adopted = adopted;
+    arena->regions[arena->regions_num++].bytes = bytes;
+
+    arena->pages = grow_array(arena->pages, &arena->pages_capacity, arena->pages_num + pages, sizeof(*arena->pages));
+    const size_t first = arena->pages_num;
+    for (size_t i = 0; i < pages; i++)
+        arena->pages[arena->pages_num++] = memory + (i << ARENA_PAGE_SHIFT);
+
+    return first;
+}
+
+uint32_t arena_append(const string_arena arena, const char* str, const size_t n)
+{
+    if (arena->pages_num == 0 || arena->used + n + 1 > arena->limit)
+    {
+        // strings longer than a page get a region of their own
+        // zeroed, as pages are saved whole and the unused tail of a page must not carry garbage to the snapshot
+        const size_t bytes = (n + 1 > ARENA_PAGE_SIZE)? ((n + 1 + ARENA_PAGE_MASK) & ~(size_t)ARENA_PAGE_MASK): ARENA_PAGE_SIZE;
+        arena->current = arena_add_region(arena, custom_calloc(1, bytes), bytes, false);
+        arena->used = 0;
+        arena->limit = bytes;
+    }
+
+    // the offset may point past the current page, into the next pages of its region
+    const uint32_t offset = (uint32_t)((arena->current << ARENA_PAGE_SHIFT) + arena->used);
+    char* dest = arena->pages[arena->current] + arena->used;
+    memcpy(dest, str, n);
+    dest[n] = '\0';
+
+    arena->used += n + 1;
+    return offset;
+}
+
+const char* arena_get(const string_arena arena, const uint32_t offset)
+{
+    return arena->pages[offset >> ARENA_PAGE_SHIFT] + (offset & ARENA_PAGE_MASK);
+}
+
+uint32_t arena_merge(const string_arena dest, const string_arena src)
+{
+    const uint32_t base = (uint32_t)(dest->pages_num << ARENA_PAGE_SHIFT);
+
+    // the pages of src keep their order, so every offset of src moves by the same amount
+    for (size_t i = 0; i < src->regions_num; i++)
+        arena_add_region(dest, src->regions[i].memory, src->regions[i].bytes, src->regions[i].adopted);
+
+    free(src->pages);
+    free(src->regions);
+    free(src);
+    return base;
+}
+
+bool arena_save(const string_arena arena, FILE* file, size_t* bytes)
+{
+    // every page is written whole, its offsets depend only on its index
+    for (size_t i = 0; i < arena->pages_num; i++)
+        if (fwrite(arena->pages[i], ARENA_PAGE_SIZE, 1, file) != 1) return false;
+
+    *bytes = arena->pages_num << ARENA_PAGE_SHIFT;
+    return true;
+}
+
+uint32_t arena_adopt(const string_arena arena, char* memory, const size_t bytes)
+{
+    if (bytes == 0) return 0;
+    const size_t first = arena_add_region(arena, memory, bytes, true);
+
+    // the adopted pages are full, the next string starts a new region
+    arena->current = arena->pages_num-1;
+    arena->used = arena->limit = 0;
+    return (uint32_t)(first << ARENA_PAGE_SHIFT);
+}
+
+size_t arena_bytes(const string_arena arena)
+{
+    size_t bytes = sizeof(*arena);
+    for (size_t i = 0; i < arena->regions_num; i++)
+        if (!arena->regions[i].adopted) bytes += arena->regions[i].bytes;
+
+    return bytes + arena->pages_capacity * sizeof(*arena->pages) + arena->regions_capacity * sizeof(*arena->regions);
+}
+
+size_t arena_destroy(const string_arena arena)
+{
+    const size_t bytes = arena_bytes(arena);
+    for (size_t i = 0; i < arena->regions_num; i++)
+        if (!arena->regions[i].adopted) free(arena->regions[i].memory);
+
+    free(arena->pages);
+    free(arena->regions);
+    free(arena);
+    return bytes;
+}
+
+
+//////////////////////////////////////////////////////
+// voter pool
+/////////////////////////////////////////////////////
+
+typedef struct _pool_chunk* pool_chunk;
+struct _pool_chunk
+{
+    pool_chunk next;                          // the previously allocated chunk
+    size_t used;                              // the number of voters handed out from the chunk
+    struct _voter voters[POOL_CHUNK_VOTERS];  // the voters of the chunk
+};
+
+// voters that are contiguous in memory and were saved one after the other
+typedef struct
+{
+    voter first;      // the first voter
+    size_t num;       // the number of voters
+    size_t position;  // the position the first voter was saved at
+}
+pool_span;
+
+struct _voter_pool
+{
+    pool_chunk chunks;       // the chunks allocated so far, the newest first
+    voter* free_voters;      // voters that were given back
+    size_t free_num;         // the number of voters given back
+    size_t free_capacity;    // the capacity of the free voters array
+    voter adopted;           // voters adopted from a snapshot, not freed by the pool
+    size_t adopted_num;      // the number of adopted voters
+    pool_span* spans;        // where every voter was saved, sorted by address
+    size_t spans_num;        // the number of spans
+    size_t spans_capacity;   // the capacity of the spans array
+};
+
+voter_pool pool_create(void)
+{
+    return custom_calloc(1, sizeof(struct _voter_pool));
+}
+
+voter pool_alloc(const voter_pool pool)
+{
+    // reuse a voter that was given back
+    if (pool->free_num > 0) return pool->free_voters[--pool->free_num];
+
+    if (pool->chunks == NULL || pool->chunks->used == POOL_CHUNK_VOTERS)
+    {
+        // zeroed, as voters are saved as they are and their padding must not carry garbage to the snapshot
+        const pool_chunk new_chunk = custom_calloc(1, sizeof(*new_chunk));
+        new_chunk->next = pool->chunks;
+        pool->chunks = new_chunk;
+    }
+
+    // hand out the voters of the newest chunk in order
+    return &pool->chunks->voters[pool->chunks->used++];
+}
+
+void pool_release(const voter_pool pool, const voter v)
+{
+    pool->free_voters = grow_array(pool->free_voters, &pool->free_capacity, pool->free_num+1, sizeof(*pool->free_voters));
+    pool->free_voters[pool->free_num++] = v;
+}
+
+void pool_merge(const voter_pool dest, const voter_pool src)
+{
+    // place the chunks of src after the newest chunk of dest, so that dest keeps filling it
+    // the chunks of src that are not full stay so, every chunk knows how many of its voters are used
+    if (src->chunks != NULL)
+    {
+        pool_chunk last = src->chunks;
+        while (last->next != NULL) last = last->next;
+
+        if (dest->chunks == NULL) dest->chunks = src->chunks;
+        else
+        {
+            last->next = dest->chunks->next;
+            dest->chunks->next = src->chunks;
+        }
+    }
+
+    for (size_t i = 0; i < src->free_num; i++)
+        pool_release(dest, src->free_voters[i]);
+
+    free(src->free_voters);
+    free(src->spans);
+    free(src);
+}
+
+// orders spans by the address of their first voter
+static int compare_spans(const void* a, const void* b)
+{
+    const voter first_a = ((const pool_span*)a)->first, first_b = ((const pool_span*)b)->first;
+    return (first_a > first_b) - (first_a < first_b);
+}
+
+// writes the voters of the span and remembers where they were written
+static bool save_span(const voter_pool pool, FILE* file, const voter first, const size_t num, size_t* position)
+{
+    if (num == 0) return true;
+    if (fwrite(first, sizeof(*first), num, file) != num) return false;
+
+    pool->spans = grow_array(pool->spans, &pool->spans_capacity, pool->spans_num+1, sizeof(*pool->spans));
+    pool->spans[pool->spans_num++] = (pool_span){ first, num, *position };
+    *position += num;
+    return true;
+}
+
+bool pool_save(const voter_pool pool, FILE* file, size_t* voters_num)
+{
+    size_t position = 0;
+    pool->spans_num = 0;
+
+    // the adopted voters, then the used part of every chunk
+    // voters that were given back are written too, nothing refers to them
+    if (!save_span(pool, file, pool->adopted, pool->adopted_num, &position)) return false;
+    for (pool_chunk chunk = pool->chunks; chunk != NULL; chunk = chunk->next)
+        if (!save_span(pool, file, chunk->voters, chunk->used, &position)) return false;
+
+    qsort(pool->spans, pool->spans_num, sizeof(*pool->spans), compare_spans);
+    *voters_num = position;
+    return true;
+}
+
+uint32_t pool_position(const voter_pool pool, const voter v)
+{
+    // binary search for the last span that starts at or before the voter
+    size_t low = 0, high = pool->spans_num;
+    while (high - low > 1)
+    {
+        const size_t mid = (low + high) / 2;
+        if (pool->spans[mid].first <= v) low = mid;
+        else high = mid;
+    }
+    return (uint32_t)(pool->spans[low].position + (v - pool->spans[low].first));
+}
+
+void pool_adopt(const voter_pool pool, const voter voters, const size_t num)
+{
+    pool->adopted = voters;
+    pool->adopted_num = num;
+}
+
+size_t pool_bytes(const voter_pool pool)
+{
+    size_t bytes = sizeof(*pool);
+    for (pool_chunk chunk = pool->chunks; chunk != NULL; chunk = chunk->next)
+        bytes += sizeof(*chunk);
+
+    return bytes + pool->free_capacity * sizeof(*pool->free_voters) + pool->spans_capacity * sizeof(*pool->spans);
+}
+
+size_t pool_destroy(const voter_pool pool)
+{
+    const size_t bytes = pool_bytes(pool);
+    pool_chunk chunk = pool->chunks;
+    while (chunk != NULL)
+    {
+        const pool_chunk tmp = chunk;
+        chunk = chunk->next;
+        free(tmp);
+    }
+
+    free(pool->free_voters);
+    free(pool->spans);
+    free(pool);
+    return bytes;
+}
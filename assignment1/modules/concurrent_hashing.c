@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/concurrent_hashing.h"
+#include "../include/utilities.h"
+
+// the number of buckets carved from every slab
+#define CH_SLAB_BUCKETS 1024
+
+// the level (i) of the table is kept at the high bits of its state and p at the low ones,
+// so that both are read at once
+#define STATE_LEVEL_SHIFT 48
+#define STATE_P_MASK ((1ull << STATE_LEVEL_SHIFT) - 1)
+
+// the fields lookups read while writers may change them are always accessed atomically
+#define LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define LOAD_ACQUIRE(field) __atomic_load_n(&(field), __ATOMIC_ACQUIRE)
+#define STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+#define STORE_RELEASE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELEASE)
+
+// every bucket is a fixed-size block: the node header, its elements and then its keys
+typedef struct _chash_node* chash_node;
+struct _chash_node
+{
+    chash_node next;       // overflow bucket
+    uint32_t number_used;  // number of elements used in the bucket
+};
+
+typedef struct _chash_slot* chash_slot;
+struct _chash_slot
+{
+    uint32_t lock;        // held by the writer of the bucket
+    uint32_t generation;  // changes every time a split retires the chain of the bucket
+    chash_node head;      // the chain of the bucket
+};
+
+// a slab of memory that buckets are carved from
+typedef struct _chash_slab* chash_slab;
+struct _chash_slab
+{
+    chash_slab next;  // the previously allocated slab
+};
+
+struct _concurrent_hash
+{
+    chash_slot* segments;        // the directory of segments, CH_MAX_SEGMENTS of them
+    uint64_t state;              // the level and the next bucket to be split
+    size_t elements_num;         // the number of elements stored currently in the hash table
+    size_t m;                    // the number of buckets the table started with
+    size_t bucket_size;          // the number of elements that can fit in a bucket
+    HashFunc hash;               // hash function
+    split_policy policy;         // when buckets are split
+    size_t segment_bytes;        // the bytes of the segments
+    pthread_mutex_t split_lock;  // held by the thread that splits buckets
+
+    // the allocator of the buckets, buckets given back are recycled but never freed
+    pthread_mutex_t pool_lock;   // held while a bucket is taken or given back
+    chash_slab slabs;            // the slabs allocated so far
+    chash_node free_buckets;     // recycled buckets, linked through next
+    char* cursor;                // the next block to be carved from the newest slab
+    size_t blocks_left;          // the number of blocks left to carve from the newest slab
+    size_t block_size;           // the bytes of a block
+    size_t pool_bytes;           // the bytes allocated for slabs
+};
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline data_t* node_data(const chash_node bucket)
+{
+    return (data_t*)(bucket + 1);
+}
+
+static inline value_t* node_keys(const concurrent_hash ht, const chash_node bucket)
+{
+    return (value_t*)(node_data(bucket) + ht->bucket_size);
+}
+
+// the bucket of the hash at the given state of the table
+static inline size_t bucket_of(const concurrent_hash ht, const uint64_t state, const hash_t hash)
+{
+    const size_t powi = ht->m << (state >> STATE_LEVEL_SHIFT);
+    const size_t bucket = hash % powi;
+    return (bucket < (state & STATE_P_MASK))? hash % (2 * powi): bucket;
+}
+
+// the number of buckets in use at the given state of the table
+static inline size_t state_buckets(const concurrent_hash ht, const uint64_t state)
+{
+    return (ht->m << (state >> STATE_LEVEL_SHIFT)) + (state & STATE_P_MASK);
+}
+
+static inline chash_slot slot_at(const concurrent_hash ht, const size_t index)
+{
+    return LOAD_ACQUIRE(ht->segments[index >> CH_SEGMENT_SHIFT]) + (index & CH_SEGMENT_MASK);
+}
+
+static inline void slot_lock(const chash_slot slot)
+{
+    while (__atomic_exchange_n(&slot->lock, 1, __ATOMIC_ACQUIRE) != 0)
+        while (LOAD(slot->lock) != 0) cpu_relax();
+}
+
+static inline void slot_unlock(const chash_slot slot)
+{
+    STORE_RELEASE(slot->lock, 0);
+}
+
+// add the segment at the given position of the directory, made by the splitting thread only
+static void add_segment(const concurrent_hash ht, const size_t segment)
+{
+    STORE_RELEASE(ht->segments[segment], custom_calloc(CH_SEGMENT_SIZE, sizeof(struct _chash_slot)));
+    ht->segment_bytes += CH_SEGMENT_SIZE * sizeof(struct _chash_slot);
+}
+
+concurrent_hash chash_create(const size_t m, const size_t bucket_size, const HashFunc hash)
+{
+    // the user failed to give a hash function
+    if (hash == NULL) return NULL;
+
+    const concurrent_hash ht = custom_calloc(1, sizeof(*ht));
+    ht->m = (m > 0)? m: 1;
+    ht->bucket_size = (bucket_size > 0)? bucket_size: 1;
+    ht->hash = hash;
+    ht->policy = split_policy_default();
+    pthread_mutex_init(&ht->split_lock, NULL);
+    pthread_mutex_init(&ht->pool_lock, NULL);
+
+    // the directory is never reallocated, only the segments for the starting buckets are allocated
+    ht->segments = custom_calloc(CH_MAX_SEGMENTS, sizeof(*ht->segments));
+    for (size_t i = 0; i < (ht->m + CH_SEGMENT_MASK) >> CH_SEGMENT_SHIFT && i < CH_MAX_SEGMENTS; i++)
+        add_segment(ht, i);
+
+    // blocks are kept aligned to the pointers they start with
+    const size_t block_size = sizeof(struct _chash_node) + ht->bucket_size * (sizeof(data_t) + sizeof(value_t));
+    ht->block_size = (block_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    return ht;
+}
+
+void chash_set_policy(const concurrent_hash ht, const split_policy* policy)
+{
+    ht->policy = *policy;
+}
+
+// gets an empty bucket, recycling a released one if possible
+static chash_node create_bucket(const concurrent_hash ht)
+{
+    pthread_mutex_lock(&ht->pool_lock);
+    chash_node new_bucket = ht->free_buckets;
+    if (new_bucket != NULL)
+        ht->free_buckets = LOAD(new_bucket->next);
+    else
+    {
+        if (ht->blocks_left == 0)
+        {
+            // zeroed, so that a lookup that strays into a block never follows garbage
+            const chash_slab new_slab = custom_calloc(1, sizeof(struct _chash_slab) + CH_SLAB_BUCKETS * ht->block_size);
+            new_slab->next = ht->slabs;
+            ht->slabs = new_slab;
+            ht->pool_bytes += sizeof(struct _chash_slab) + CH_SLAB_BUCKETS * ht->block_size;
+            ht->cursor = (char*)(new_slab + 1);
+            ht->blocks_left = CH_SLAB_BUCKETS;
+        }
+
+        new_bucket = (chash_node)ht->cursor;
+        ht->cursor += ht->block_size;
+        ht->blocks_left--;
+    }
+    pthread_mutex_unlock(&ht->pool_lock);
+
+    // a lookup still reading the bucket from its previous chain must see its chain retired
+    // before anything written from now on
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    STORE(new_bucket->number_used, 0);
+    STORE(new_bucket->next, NULL);
+    return new_bucket;
+}
+
+// return a bucket, that no chain leads to anymore, so it can be reused
+static void release_bucket(const concurrent_hash ht, const chash_node bucket)
+{
+    pthread_mutex_lock(&ht->pool_lock);
+    STORE(bucket->next, ht->free_buckets);
+    ht->free_buckets = bucket;
+    pthread_mutex_unlock(&ht->pool_lock);
+}
+
+// scan a bucket for the key, the bucket may be written at the same time
+static inline data_t node_find(const concurrent_hash ht, const chash_node bucket, const value_t key)
+{
+    // the elements are written before the number of elements grows
+    uint32_t used = LOAD_ACQUIRE(bucket->number_used);
+    if (used > ht->bucket_size) used = ht->bucket_size;
+
+    const value_t* keys = node_keys(ht, bucket);
+    for (uint32_t i = 0; i < used; i++)
+        if (LOAD(keys[i]) == key) return LOAD(node_data(bucket)[i]);
+
+    return NULL;
+}
+
+// append an element at the chain of the slot, whose lock is held
+static inline void chain_push(const concurrent_hash ht, const chash_slot slot, const value_t key, const data_t value)
+{
+    const chash_node head = slot->head;
+    if (head != NULL && head->number_used < ht->bucket_size)  // element can be inserted at the bucket
+    {
+        const uint32_t used = head->number_used;
+        STORE(node_keys(ht, head)[used], key);
+        STORE(node_data(head)[used], value);
+        STORE_RELEASE(head->number_used, used + 1);
+    }
+    else  // no empty spots found, create an overflow bucket
+    {
+        const chash_node new_bucket = create_bucket(ht);
+        STORE(node_keys(ht, new_bucket)[0], key);
+        STORE(node_data(new_bucket)[0], value);
+        STORE(new_bucket->number_used, 1);
+        STORE(new_bucket->next, head);
+        STORE_RELEASE(slot->head, new_bucket);
+    }
+}
+
+data_t chash_search(const concurrent_hash ht, const value_t key)
+{
+    const hash_t hash = ht->hash(key);
+    for (;;)
+    {
+        const size_t index = bucket_of(ht, LOAD_ACQUIRE(ht->state), hash);
+        const chash_slot slot = slot_at(ht, index);
+        const uint32_t generation = LOAD_ACQUIRE(slot->generation);
+
+        data_t found = NULL;
+        bool retired = false;
+        for (chash_node bucket = LOAD_ACQUIRE(slot->head); bucket != NULL; bucket = LOAD_ACQUIRE(bucket->next))
+        {
+            found = node_find(ht, bucket, key);
+
+            // the chain was retired by a split meanwhile, so its buckets may be reused by any other
+            // chain, checked after every bucket as such a chain may lead anywhere
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (LOAD(slot->generation) != generation)
+            {
+                retired = true;
+                break;
+            }
+            if (found != NULL) return found;
+        }
+        if (retired) continue;
+
+        // the key may have been moved by a split that retired the chain before it was read
+        if (bucket_of(ht, LOAD_ACQUIRE(ht->state), hash) == index) return NULL;
+    }
+}
+
+// split operation, made by a single thread at a time
+// the chain of p is left as is while the elements that stay are copied to a new chain and the rest
+// to the new bucket, then the new chain takes its place and the old one is retired
+// returns false if the directory can not address another bucket
+static bool bucket_split(const concurrent_hash ht)
+{
+    const uint64_t state = LOAD(ht->state);
+    const size_t level = state >> STATE_LEVEL_SHIFT;
+    const size_t p = state & STATE_P_MASK;
+    const size_t powi = ht->m << level;
+    const size_t new_index = powi + p;
+
+    if (new_index >= (size_t)CH_MAX_SEGMENTS * CH_SEGMENT_SIZE) return false;
+    if (LOAD(ht->segments[new_index >> CH_SEGMENT_SHIFT]) == NULL) add_segment(ht, new_index >> CH_SEGMENT_SHIFT);
+
+    const chash_slot old_slot = slot_at(ht, p);
+    const chash_slot new_slot = slot_at(ht, new_index);
+    slot_lock(old_slot);
+    slot_lock(new_slot);
+
+    struct _chash_slot staying = { 0, 0, NULL };
+    for (chash_node bucket = old_slot->head; bucket != NULL; bucket = bucket->next)
+    {
+        for (uint32_t i = 0; i < bucket->number_used; i++)
+        {
+            const value_t key = node_keys(ht, bucket)[i];
+            if (ht->hash(key) % (2 * powi) != p)  // hashing does not map back to the old bucket
+                chain_push(ht, new_slot, key, node_data(bucket)[i]);
+            else
+                chain_push(ht, &staying, key, node_data(bucket)[i]);
+        }
+    }
+
+    // the moved elements are at the new bucket before the state leads to it,
+    // and the state leads to it before they leave the old one
+    const uint64_t next_state = (p + 1 == powi)? (uint64_t)(level + 1) << STATE_LEVEL_SHIFT: state + 1;
+    STORE_RELEASE(ht->state, next_state);
+
+    chash_node retired = old_slot->head;
+    STORE_RELEASE(old_slot->head, staying.head);
+    __atomic_fetch_add(&old_slot->generation, 1, __ATOMIC_RELEASE);
+
+    slot_unlock(new_slot);
+    slot_unlock(old_slot);
+
+    while (retired != NULL)
+    {
+        const chash_node tmp = retired;
+        retired = retired->next;
+        release_bucket(ht, tmp);
+    }
+    return true;
+}
+
+// true if lamda exceeded the limit of the policy
+static inline bool needs_split(const concurrent_hash ht)
+{
+    const size_t buckets = state_buckets(ht, LOAD(ht->state));
+    return split_policy_splits(&ht->policy, LOAD(ht->elements_num), buckets * ht->bucket_size, ht->bucket_size) > 0;
+}
+
+// split buckets until lamda falls back to the limit of the policy
+// if another thread is splitting already it catches up instead, so no insert waits for splits
+static void chash_check_split(const concurrent_hash ht)
+{
+    if (!needs_split(ht) || pthread_mutex_trylock(&ht->split_lock) != 0) return;
+
+    while (needs_split(ht) && bucket_split(ht));
+    pthread_mutex_unlock(&ht->split_lock);
+}
+
+bool chash_insert(const concurrent_hash ht, const data_t value)
+{
+    const value_t key = get_key(value);
+    const hash_t hash = ht->hash(key);
+
+    // lock the bucket of the key, making sure it was not split before it was locked
+    // once locked, it can not be split until the insertion is over
+    chash_slot slot;
+    for (;;)
+    {
+        const size_t index = bucket_of(ht, LOAD_ACQUIRE(ht->state), hash);
+        slot = slot_at(ht, index);
+        slot_lock(slot);
+        if (bucket_of(ht, LOAD_ACQUIRE(ht->state), hash) == index) break;
+        slot_unlock(slot);
+    }
+
+    // check if the value exists before inserting to avoid duplicates
+    for (chash_node bucket = slot->head; bucket != NULL; bucket = bucket->next)
+    {
+        if (node_find(ht, bucket, key) != NULL)
+        {
+            slot_unlock(slot);
+            return false;
+        }
+    }
+
+    chain_push(ht, slot, key, value);
+    slot_unlock(slot);
+
+    __atomic_fetch_add(&ht->elements_num, 1, __ATOMIC_RELAXED);
+    chash_check_split(ht);
+    return true;
+}
+
+size_t chash_size(const concurrent_hash ht)  { return LOAD(ht->elements_num); }
+
+size_t chash_buckets(const concurrent_hash ht)  { return state_buckets(ht, LOAD(ht->state)); }
+
+size_t chash_destroy(const concurrent_hash ht)
+{
+    const size_t bytes_destroyed = sizeof(*ht) + ht->pool_bytes + ht->segment_bytes + CH_MAX_SEGMENTS * sizeof(*ht->segments);
+
+    chash_slab curr_slab = ht->slabs;
+    while (curr_slab != NULL)
+    {
+        const chash_slab tmp = curr_slab;
+        curr_slab = curr_slab->next;
+        free(tmp);
+    }
+
+    for (size_t i = 0; i < CH_MAX_SEGMENTS; i++) free(ht->segments[i]);
+    free(ht->segments);
+
+    pthread_mutex_destroy(&ht->split_lock);
+    pthread_mutex_destroy(&ht->pool_lock);
+    free(ht);
+    return bytes_destroyed;
+}
@@ -2,44 +2,43 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../include/linear_hashing.h"
+#include "../include/linear_hashing_inline.h"
 #include "../include/utilities.h"
+#include "../include/arena.h"
+#include "../include/output.h"
 
-// when to split
-#define LAMDA_SPLIT 0.75
+// the number of buckets carved from the first slab, later slabs double up to the max
+#define SLAB_MIN_BUCKETS 16
+#define SLAB_MAX_BUCKETS 4096
 
-// wrap the data in a struct
-typedef struct data_info
-{
-    data_t key;
-}
-data_info;
+// by default grow by one
+size_t _my_default_expand(size_t num)  { return num + 1; }
 
-typedef struct _node* node;
-struct _node
+// add a segment of empty buckets at the end of the directory
+// only the directory (one pointer per segment) is ever reallocated
+static void add_segment(const hash_table ht)
 {
-    data_info* data;       // the bucket we are storing
-    uint32_t number_used;  // number of elements used in the bucket
-    node next_bucket;      // overflow bucket
-};
+    if (ht->segments_num == ht->directory_size)
+    {
+        const size_t old_size = ht->directory_size;
+        const size_t new_size = ht->expand(old_size);
 
-struct _linear_hash
-{
-    node* nodes;           // the array of nodes
-    size_t p;              // the next bucket to be split
-    size_t i;              // the exponenent of the hash function
-    size_t elements_num;   // the number of elements stored currently in the hash table
-    size_t curr_capacity;  // the current amount of buckects being used
-    size_t max_capacity;   // the maximum number of buckects that can be used (allocated)
-    size_t capacity;       // the maximum capacity of elements in non-overflow buckets
-    size_t bucket_size;    // the number of elements that can fit in a bucket
-    size_t powi;           // 2^i * m
-    size_t powi_1;         // 2^(i+1) * m
-    HashFunc hash;         // hash function
-    ExpandFunc expand;     // expand function
-};
+        // check if the new size the user gave is valid
+        // if not valid, use the default grow function
+        ht->directory_size = (old_size < new_size)? new_size: _my_default_expand(old_size);
 
-// by default grow by one
-size_t _my_default_expand(size_t num)  { return num + 1; }
+        ht->segments = realloc(ht->segments, sizeof(*ht->segments) * ht->directory_size);
+        ht->directory_reallocs++;
+        if (ht->segments == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ht->segments[ht->segments_num++] = custom_calloc(SEGMENT_SIZE, sizeof(**ht->segments));
+    ht->max_capacity += SEGMENT_SIZE;
+}
 
 hash_table hash_create(const size_t m, const size_t bucket_size, const HashFunc hash, const ExpandFunc expand)
 {
@@ -51,17 +50,25 @@ hash_table hash_create(const size_t m, const size_t bucket_size, const HashFunc
     ht->expand = ((expand != NULL)? expand: _my_default_expand);
 
     ht->curr_capacity = m;
+    ht->min_buckets = m;
 
-    ht->max_capacity = ht->expand(m);
-    if (m > ht->max_capacity) ht->max_capacity = _my_default_expand(m);
-
-    ht->nodes = custom_calloc(ht->max_capacity, sizeof(*ht->nodes));
+    // allocate enough segments for the starting buckets
+    ht->directory_size = (m + SEGMENT_MASK) >> SEGMENT_SHIFT;
+    ht->segments = custom_malloc(ht->directory_size * sizeof(*ht->segments));
+    while (ht->max_capacity < m) add_segment(ht);
 
     ht->bucket_size = bucket_size;
     ht->hash = hash;
     ht->powi = m;      // i = 0 so 2^0 * m = 1 * m = m
     ht->powi_1 = 2*m;  // i = 1 so 2^1 * m = 2 * m
     ht->capacity = ht->curr_capacity * ht->bucket_size;
+
+    // blocks are kept aligned to the pointers they start with
+    const size_t block_size = sizeof(struct _node) + bucket_size * (sizeof(data_t) + sizeof(value_t));
+    ht->pool.block_size = (block_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    ht->pool.slab_blocks = SLAB_MIN_BUCKETS;
+
+    ht->policy = split_policy_default();
     return ht;
 }
 
@@ -73,37 +80,80 @@ static inline float calculate_lamda(const hash_table ht)
 
 size_t hash_size(const hash_table ht)  { return ht->elements_num; }
 
-// allocates memory for a bucket
+size_t hash_presize(const size_t elements, const size_t bucket_size, const double split_load)
+{
+    // the smallest m for which elements / (m * bucket_size) does not exceed the split limit
+    const size_t m = (size_t)((double)elements / (bucket_size * split_load)) + 1;
+    return (m > 0)? m: 1;
+}
+
+void hash_set_policy(const hash_table ht, const split_policy* policy)
+{
+    ht->policy = *policy;
+    if (ht->policy.max_splits == 0) ht->policy.max_splits = 1;
+}
+
+// allocates a new slab and makes it the one blocks are carved from
+static void pool_grow(const hash_table ht)
+{
+    struct _bucket_pool* pool = &ht->pool;
+
+    const size_t size = sizeof(struct _slab) + pool->slab_blocks * pool->block_size;
+    const slab new_slab = custom_malloc(size);
+    new_slab->size = size;
+    new_slab->next = pool->slabs;
+    pool->slabs = new_slab;
+    pool->bytes += size;
+
+    pool->cursor = (char*)(new_slab + 1);
+    pool->blocks_left = pool->slab_blocks;
+
+    // grow geometrically so that big tables need few slabs
+    if (pool->slab_blocks < SLAB_MAX_BUCKETS) pool->slab_blocks *= 2;
+}
+
+// gets an empty bucket from the pool, recycling a released one if possible
 static inline node create_bucket(const hash_table ht)
 {
-    const node new_bucket = custom_malloc(sizeof(*new_bucket));
-    new_bucket->data = custom_malloc(ht->bucket_size * sizeof(*new_bucket->data));
+    struct _bucket_pool* pool = &ht->pool;
+
+    node new_bucket = pool->free_buckets;
+    if (new_bucket != NULL)
+        pool->free_buckets = new_bucket->next_bucket;
+    else
+    {
+        if (pool->blocks_left == 0) pool_grow(ht);
+
+        // carve a new block, its arrays follow the header and never move
+        new_bucket = (node)pool->cursor;
+        new_bucket->data = (data_t*)(new_bucket + 1);
+        new_bucket->keys = (value_t*)(new_bucket->data + ht->bucket_size);
+        pool->cursor += pool->block_size;
+        pool->blocks_left--;
+    }
+
     new_bucket->number_used = 0;
     new_bucket->next_bucket = NULL;
+    pool->used++;
     return new_bucket;
 }
 
-// insert bucket at the specified index
-static inline void insert_bucket(const hash_table ht, const size_t index)
+// return a bucket to the pool so it can be reused
+static inline void release_bucket(const hash_table ht, const node bucket)
 {
-    const node new_bucket = custom_malloc(sizeof(*new_bucket));
-    new_bucket->data = custom_malloc(ht->bucket_size * sizeof(*new_bucket->data));
-    new_bucket->number_used = 0;
-
-    new_bucket->next_bucket = ht->nodes[index];
-    ht->nodes[index] = new_bucket;
+    bucket->next_bucket = ht->pool.free_buckets;
+    ht->pool.free_buckets = bucket;
+    ht->pool.used--;
 }
 
-// calculate the hash value of the key
+// the lookups through the hash function of the table
+#define TABLE_HASH(key) ht->hash(key)
+LH_SPECIALIZE(table, TABLE_HASH, )
+
+// calculate the bucket of the key
 static inline hash_t calculate_hash(const hash_table ht, const value_t key)
 {
-    const hash_t hash = ht->hash(key);
-
-    // use h_1
-    const hash_t h_1 = hash % ht->powi;
-
-    // use h_2 (if h_1 < p)
-    return (h_1 < ht->p? hash % ht->powi_1: h_1);
+    return table_bucket(ht, key);
 }
 
 // at split we only use h_2
@@ -115,49 +165,25 @@ static inline hash_t calculate_hash_split(const hash_table ht, const value_t key
 // search the ht for the specified key
 static inline data_t hash_exists(const hash_table ht, const value_t key, const hash_t hash_value)
 {
-    node curr_bucket = ht->nodes[hash_value];
-    while (curr_bucket != NULL)
-    {
-        for (size_t i = 0; i < curr_bucket->number_used; i++)
-        {
-            // compare the values
-            if (get_key(curr_bucket->data[i].key) == key)  // key matches
-                return curr_bucket->data[i].key;
-        }
-        curr_bucket = curr_bucket->next_bucket;
-    }
-    
-    return NULL;
+    return chain_find(*bucket_at(ht, hash_value), key);
 }
 
 data_t hash_search(const hash_table ht, const value_t key)
 {
-    return hash_exists(ht, key, calculate_hash(ht, key));
+    return table_search(ht, key);
+}
+
+void hash_search_many(const hash_table ht, const value_t* keys, const size_t n, data_t* found)
+{
+    table_search_many(ht, keys, n, found);
 }
 
 // resize the hash table
-// we expand by one the max capacity. we could double but setting as zero the bytes after the resize is expensive
-static void hash_resize(const hash_table ht)
+// the new bucket is the next one of its segment, a segment is added only when the last one is full
+static inline void hash_resize(const hash_table ht)
 {
     ht->curr_capacity++;
-    if (ht->curr_capacity == ht->max_capacity)
-    {
-        const size_t old_capacity = ht->curr_capacity;
-        const size_t new_capacity = ht->expand(ht->curr_capacity);
-        
-        // check if the new size the user gave is valid
-        // if not valid, use the default grow function
-        ht->max_capacity = (old_capacity < new_capacity)? new_capacity: _my_default_expand(ht->curr_capacity);
-
-        ht->nodes = realloc(ht->nodes, sizeof(struct _node) * ht->max_capacity);
-        if (ht->nodes == NULL)
-        {
-            fprintf(stderr, "Memory allocation failed. Exiting..\n");
-            exit(EXIT_FAILURE);
-        }
-
-        memset(ht->nodes+old_capacity, 0, (ht->max_capacity - old_capacity) * sizeof(struct _node));
-    }
+    if (ht->curr_capacity > ht->max_capacity) add_segment(ht);
 
     ht->capacity += ht->bucket_size;  // incrementally update the capacity in non overflow buckets
 }
@@ -166,12 +192,15 @@ static void hash_resize(const hash_table ht)
 static inline void temp_insert(const hash_table ht, const data_t key, node* bucket)
 {
     if (*bucket != NULL && (*bucket)->number_used < ht->bucket_size)  // element can be inserted at the bucket
-        (*bucket)->data[(*bucket)->number_used++].key = key;
+    {
+        (*bucket)->keys[(*bucket)->number_used] = get_key(key);
+        (*bucket)->data[(*bucket)->number_used++] = key;
+    }
     else  // no empty spots found, create an overflow bucket
     {
-        const node new_bucket = custom_malloc(sizeof(*new_bucket));
-        new_bucket->data = custom_malloc(ht->bucket_size * sizeof(*new_bucket->data));
-        new_bucket->data[0].key = key;
+        const node new_bucket = create_bucket(ht);
+        new_bucket->keys[0] = get_key(key);
+        new_bucket->data[0] = key;
         new_bucket->number_used = 1;
         
         new_bucket->next_bucket = *bucket;
@@ -180,61 +209,76 @@ static inline void temp_insert(const hash_table ht, const data_t key, node* buck
 }
 
 // split operation
+// the elements that stay are compacted in place at the front of the old chain
+// and the buckets left empty are given back to the pool
 static inline void bucket_split(const hash_table ht)
 {
     // we split with the new index and p
     const size_t new_index = ht->curr_capacity-1;
 
-    // buckets that will be splitted between p & new_index
-    node buckets = ht->nodes[ht->p];
-
-    node new_buckets = create_bucket(ht);
-    insert_bucket(ht, new_index);
+    // where the next element that stays in p will be written
+    node* write_link = bucket_at(ht, ht->p);
+    node write_bucket = *write_link;
+    uint32_t write_pos = 0;
 
-    while (buckets != NULL)
+    // the write position never overtakes the read position, so nothing is overwritten before being read
+    for (node read_bucket = *bucket_at(ht, ht->p); read_bucket != NULL; read_bucket = read_bucket->next_bucket)
     {
-        for (size_t i = 0; i < buckets->number_used; i++)
+        for (uint32_t i = 0; i < read_bucket->number_used; i++)
         {
             // hashing does not map back to the old bucket
-            if (calculate_hash_split(ht, get_key(buckets->data[i].key)) != ht->p)
-                temp_insert(ht, buckets->data[i].key, &ht->nodes[new_index]);
-            else
-                temp_insert(ht, buckets->data[i].key, &new_buckets);
+            if (calculate_hash_split(ht, read_bucket->keys[i]) != ht->p)
+            {
+                temp_insert(ht, read_bucket->data[i], bucket_at(ht, new_index));
+                continue;
+            }
+
+            write_bucket->keys[write_pos] = read_bucket->keys[i];
+            write_bucket->data[write_pos++] = read_bucket->data[i];
+            if (write_pos == ht->bucket_size)  // bucket filled, move on to the next one
+            {
+                write_bucket->number_used = write_pos;
+                write_link = &write_bucket->next_bucket;
+                write_bucket = *write_link;
+                write_pos = 0;
+            }
         }
-        
-        const node tmp = buckets;
-        buckets = buckets->next_bucket;
-        free(tmp->data);
-        free(tmp);
     }
 
-    ht->nodes[ht->p] = new_buckets;
+    if (write_bucket == NULL) return;  // every bucket of the chain was filled
+    
+    // keep the bucket being written, unless it is an empty overflow bucket
+    write_bucket->number_used = write_pos;
+    if (write_pos > 0 || write_link == bucket_at(ht, ht->p))
+    {
+        write_link = &write_bucket->next_bucket;
+        write_bucket = *write_link;
+    }
+    *write_link = NULL;
+
+    // recycle the buckets left empty
+    while (write_bucket != NULL)
+    {
+        const node tmp = write_bucket;
+        write_bucket = write_bucket->next_bucket;
+        release_bucket(ht, tmp);
+    }
 }
 
-bool hash_insert(const hash_table ht, const data_t value)
+// split buckets if lamda exceeded the limit of the policy
+static inline void hash_check_split(const hash_table ht)
 {
-    // find the bucket where the value should be inserted to
-    const hash_t hash = calculate_hash(ht, get_key(value));
-
-    // check if the value exists before inserting to avoid duplicates
-    // in an implementation where it's guranteed that no duplicates exist 
-    // we could comment out this line of code and always return true for extra speed
-    if (hash_exists(ht, get_key(value), hash) != NULL) return false;
-    
-    // insert value
-    temp_insert(ht, value, &ht->nodes[hash]);
+    split_policy_adapt(&ht->policy, ht->pool.used, ht->curr_capacity);
 
-    // value inserted
-    ht->elements_num++;
-    
-    // lamda exceeded the limit, split
-    if (calculate_lamda(ht) > LAMDA_SPLIT)
+    // lamda exceeded the limit, split as many buckets as the policy asks for
+    for (size_t splits = split_policy_splits(&ht->policy, ht->elements_num, ht->capacity, ht->bucket_size); splits > 0; splits--)
     {
         // hash table needs resizing
         hash_resize(ht);
 
         // split the bucket
         bucket_split(ht);
+        ht->splits++;
 
         // start new round of splitting
         if (ht->powi_1 <= ht->curr_capacity)
@@ -245,69 +289,251 @@ bool hash_insert(const hash_table ht, const data_t value)
         }
         else ht->p++;
     }
+}
+
+// merge operation, undoes the last split
+// the elements of the last bucket are moved back to the bucket they were split from
+static inline void bucket_merge(const hash_table ht)
+{
+    // the last split started the current round, go back to the previous one
+    if (ht->p == 0)
+    {
+        ht->powi_1 = ht->powi;
+        ht->powi /= 2;
+        ht->p = ht->powi;
+    }
+    ht->p--;
+
+    node* last = bucket_at(ht, ht->curr_capacity-1);
+    node curr_bucket = *last;
+    *last = NULL;
+    while (curr_bucket != NULL)
+    {
+        for (uint32_t i = 0; i < curr_bucket->number_used; i++)
+            temp_insert(ht, curr_bucket->data[i], bucket_at(ht, ht->p));
+
+        const node tmp = curr_bucket;
+        curr_bucket = curr_bucket->next_bucket;
+        release_bucket(ht, tmp);
+    }
+
+    // the segments stay allocated, the table will probably grow again
+    ht->curr_capacity--;
+    ht->capacity -= ht->bucket_size;
+}
+
+// merge the last buckets back while lamda is below the merge limit of the policy
+// a merge takes a whole bucket of capacity away, so a removal rarely needs more than one
+static inline void hash_check_merge(const hash_table ht)
+{
+    while (split_policy_merge(&ht->policy, ht->elements_num, ht->capacity, ht->curr_capacity, ht->min_buckets))
+    {
+        bucket_merge(ht);
+        ht->merges++;
+    }
+}
+
+bool hash_insert(const hash_table ht, const data_t value)
+{
+    // find the bucket where the value should be inserted to
+    const hash_t hash = calculate_hash(ht, get_key(value));
+
+    // check if the value exists before inserting to avoid duplicates
+    // in an implementation where it's guranteed that no duplicates exist 
+    // we could comment out this line of code and always return true for extra speed
+    if (hash_exists(ht, get_key(value), hash) != NULL) return false;
+    
+    // insert value
+    temp_insert(ht, value, bucket_at(ht, hash));
+
+    // value inserted
+    ht->elements_num++;
+    hash_check_split(ht);
 
     // value inserted, increment the number of elements and return true
     return true;
 }
 
-void hash_print(const hash_table ht)
+void hash_bulk_insert(const hash_table ht, const data_t* values, const size_t n)
 {
-    for (size_t i = 0; i < ht->curr_capacity; i++)
+    for (size_t i = 0; i < n; i++)
     {
-        printf("Bucket %ld | ", i);
-        node curr_bucket = ht->nodes[i];
-        size_t buckets_num = 0;
-        while (curr_bucket != NULL)
-        {
-            if (buckets_num > 0) printf(" -Overflow bucket- ");
+        temp_insert(ht, values[i], bucket_at(ht, calculate_hash(ht, get_key(values[i]))));
+        ht->elements_num++;
 
-            for (size_t j = 0; j < curr_bucket->number_used; j++)
-                printf("%d ", get_key(curr_bucket->data[j].key));
-            
-            curr_bucket = curr_bucket->next_bucket;
-            buckets_num=1;
+        // a presized table never splits here, but an underestimated one still has to grow
+        hash_check_split(ht);
+    }
+}
+
+data_t hash_remove(const hash_table ht, const value_t key)
+{
+    node* link = bucket_at(ht, calculate_hash(ht, key));
+    for (node curr_bucket = *link; curr_bucket != NULL; link = &curr_bucket->next_bucket, curr_bucket = *link)
+    {
+        const int index = bucket_find(curr_bucket, key);
+        if (index == -1) continue;
+
+        const data_t removed = curr_bucket->data[index];
+
+        // the last element of the bucket fills the hole
+        const uint32_t last = --curr_bucket->number_used;
+        curr_bucket->keys[index] = curr_bucket->keys[last];
+        curr_bucket->data[index] = curr_bucket->data[last];
+
+        // unlink a bucket left empty and give it back to the pool
+        if (curr_bucket->number_used == 0)
+        {
+            *link = curr_bucket->next_bucket;
+            release_bucket(ht, curr_bucket);
         }
 
-        printf("\n");
+        ht->elements_num--;
+        hash_check_merge(ht);
+        return removed;
     }
+    return NULL;
+}
+
+// the shape of a saved hash table, followed by where the elements of every bucket start
+// (buckets + 1 of them) and then the positions of the elements, bucket after bucket
+typedef struct
+{
+    uint64_t bucket_size;   // the number of elements that fit in a bucket
+    uint64_t buckets;       // the number of buckets in use
+    uint64_t p;             // the next bucket to be split
+    uint64_t powi;          // 2^i * m
+    uint64_t elements_num;  // the number of elements
+    uint64_t min_buckets;   // the buckets the table started with
 }
+saved_table;
 
-// helper function that destroys the memory used by a specified voter
-static inline size_t destroy_voter(const data_t voter)
+bool hash_save(const hash_table ht, FILE* file, const voter_pool pool)
 {
-    size_t bytes = sizeof(char) * (strlen(voter->name)+1) + sizeof(char) * (strlen(voter->surname)+1);
-    free(voter->name);
-    free(voter->surname);
+    const saved_table header = { ht->bucket_size, ht->curr_capacity, ht->p, ht->powi, ht->elements_num, ht->min_buckets };
+    if (fwrite(&header, sizeof(header), 1, file) != 1) return false;
+
+    // where the elements of every bucket start
+    uint64_t start = 0;
+    for (size_t i = 0; i < ht->curr_capacity; i++)
+    {
+        if (fwrite(&start, sizeof(start), 1, file) != 1) return false;
+        for (node curr_bucket = *bucket_at(ht, i); curr_bucket != NULL; curr_bucket = curr_bucket->next_bucket)
+            start += curr_bucket->number_used;
+    }
+    if (fwrite(&start, sizeof(start), 1, file) != 1) return false;
 
-    bytes += sizeof(*voter);
-    free(voter);
-    return bytes;
+    // the elements
+    for (size_t i = 0; i < ht->curr_capacity; i++)
+    {
+        for (node curr_bucket = *bucket_at(ht, i); curr_bucket != NULL; curr_bucket = curr_bucket->next_bucket)
+        {
+            for (uint32_t j = 0; j < curr_bucket->number_used; j++)
+            {
+                const uint32_t position = pool_position(pool, curr_bucket->data[j]);
+                if (fwrite(&position, sizeof(position), 1, file) != 1) return false;
+            }
+        }
+    }
+    return true;
 }
 
-size_t hash_destroy(const hash_table ht)
+hash_table hash_load(const void* saved, const data_t elements, const HashFunc hash, const ExpandFunc expand)
 {
-    size_t bytes_destroyed = 0;  // the number of bytes we destroyed
+    const saved_table* header = saved;
+    const uint64_t* starts = (const uint64_t*)(header + 1);
+    const uint32_t* positions = (const uint32_t*)(starts + header->buckets + 1);
+
+    // the buckets in use are allocated at once, then the round of splitting is restored
+    const hash_table ht = hash_create(header->buckets, header->bucket_size, hash, expand);
+    if (ht == NULL) return NULL;
+    ht->p = header->p;
+    ht->powi = header->powi;
+    ht->powi_1 = 2 * header->powi;
+    ht->elements_num = header->elements_num;
+    ht->min_buckets = header->min_buckets;
+
+    for (size_t i = 0; i < header->buckets; i++)
+        for (uint64_t j = starts[i]; j < starts[i+1]; j++)
+            temp_insert(ht, &elements[positions[j]], bucket_at(ht, i));
+
+    return ht;
+}
+
+void hash_get_stats(const hash_table ht, hash_stats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->elements = ht->elements_num;
+    stats->buckets = ht->curr_capacity;
+    stats->bucket_size = ht->bucket_size;
+    stats->load_factor = calculate_lamda(ht);
+    stats->split_load = ht->policy.split_load;
+    stats->splits = ht->splits;
+    stats->merges = ht->merges;
+    stats->directory_reallocs = ht->directory_reallocs;
+
     for (size_t i = 0; i < ht->curr_capacity; i++)
     {
-        // scan every overflow bucket
-        node curr_bucket = ht->nodes[i];
+        size_t length = 0;
+        for (node curr_bucket = *bucket_at(ht, i); curr_bucket != NULL; curr_bucket = curr_bucket->next_bucket)
+            length++;
+        stats->chains[(length < HASH_CHAIN_LENGTHS)? length: HASH_CHAIN_LENGTHS]++;
+    }
+
+    const struct _lookup_counters* lookups = &ht->lookups;
+    stats->hits = lookups->hits;
+    stats->misses = lookups->misses;
+    stats->avg_hit_probes = (lookups->hits > 0)? (double)lookups->hit_probes / lookups->hits: 0;
+    stats->avg_miss_probes = (lookups->misses > 0)? (double)lookups->miss_probes / lookups->misses: 0;
+    stats->max_hit_probes = lookups->max_hit_probes;
+    stats->max_miss_probes = lookups->max_miss_probes;
+
+    stats->directory_bytes = sizeof(*ht->segments) * ht->directory_size;
+    stats->segment_bytes = sizeof(**ht->segments) * ht->max_capacity;
+    stats->bucket_bytes = ht->pool.bytes;
+}
+
+void hash_print(const hash_table ht, const out_buffer out)
+{
+    for (size_t i = 0; i < ht->curr_capacity; i++)
+    {
+        out_printf(out, "Bucket %ld | ", i);
+        node curr_bucket = *bucket_at(ht, i);
+        size_t buckets_num = 0;
         while (curr_bucket != NULL)
         {
-            for (size_t j = 0; j < curr_bucket->number_used; j++)
-                bytes_destroyed += destroy_voter(curr_bucket->data[j].key);
+            if (buckets_num > 0) out_string(out, " -Overflow bucket- ");
 
-            const node tmp = curr_bucket;
+            for (size_t j = 0; j < curr_bucket->number_used; j++)
+                out_printf(out, "%d ", curr_bucket->keys[j]);
+            
             curr_bucket = curr_bucket->next_bucket;
+            buckets_num=1;
+        }
 
-            bytes_destroyed += sizeof(*tmp->data) * ht->bucket_size + sizeof(*tmp);
+        out_string(out, "\n");
+    }
+}
 
-            free(tmp->data);
-            free(tmp);
-        }
+size_t hash_destroy(const hash_table ht)
+{
+    size_t bytes_destroyed = 0;  // the number of bytes we destroyed
+
+    // the buckets live in the slabs, release them all at once
+    slab curr_slab = ht->pool.slabs;
+    while (curr_slab != NULL)
+    {
+        const slab tmp = curr_slab;
+        curr_slab = curr_slab->next;
+        free(tmp);
     }
+    bytes_destroyed += ht->pool.bytes;
+
+    for (size_t i = 0; i < ht->segments_num; i++) free(ht->segments[i]);
+    bytes_destroyed += sizeof(**ht->segments) * ht->max_capacity;
 
-    bytes_destroyed += sizeof(**ht->nodes) * ht->max_capacity;
-    free(ht->nodes);
+    bytes_destroyed += sizeof(*ht->segments) * ht->directory_size;
+    free(ht->segments);
 
     bytes_destroyed += sizeof(*ht);
     free(ht);
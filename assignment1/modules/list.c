@@ -1,211 +1,158 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../include/list.h"
 #include "../include/utilities.h"
 
-typedef struct ListNode
-{
-    void* value;
-    struct ListNode* next;
-}
-ListNode;
-typedef struct ListNode* list_node_ptr;
+#define LIST_FIRST_SIZE ((size_t)1 << LIST_FIRST_SHIFT)
 
 typedef struct listSet
 {
-    list_node_ptr top;    // top node of the list
+    void*** chunks;       // the chunks of values, chunk k holding LIST_FIRST_SIZE << k values
+    uint32_t chunks_num;  // the number of chunks allocated
     size_t size;          // the number of elements stored in the list
     DestroyFunc destroy;  // function that destroys the data, NULL if want to preserve the data
 }
 listSet;
 
+// the number of values chunk k holds
+static inline size_t chunk_size(const uint32_t k)  { return LIST_FIRST_SIZE << k; }
+
+// the number of values the first k chunks hold together
+static inline size_t chunks_capacity(const uint32_t k)  { return (((size_t)1 << k) - 1) << LIST_FIRST_SHIFT; }
+
+// the chunk of the position
+static inline uint32_t chunk_of(const size_t pos)
+{
+    return 63 - __builtin_clzll((pos >> LIST_FIRST_SHIFT) + 1);
+}
+
 List list_create(const DestroyFunc destroy)
 {
     List list = custom_malloc(sizeof(*list));
+    list->chunks = NULL;
+    list->chunks_num = 0;
     list->size = 0;
     list->destroy = destroy;
-    list->top = NULL;
     return list;
 }
 
-void* list_top_value(const List list)  { return (list->top->value); }
-
 size_t list_size(const List list)  { return list->size; }
 
-void list_push(const List list, void* value)
+void* list_get(const List list, const size_t pos)
 {
-    list_node_ptr* head = &(list->top);
-
-    // create a new node
-    list_node_ptr node = custom_malloc(sizeof(ListNode));
-
-    node->value = value;
-    node->next = *head;
-    *head = node;
-
-    list->size++;  // element was inserted
-}
-
-size_t list_destroy(const List list)
-{
-    size_t bytes_freed = 0;
-    list_node_ptr head = list->top;
-
-    while (head != NULL)
-    {
-        const list_node_ptr tmp = head;
-        head = head->next;
-
-        // if a destoy function was given destroy the data and count the bytes destroyed
-        if (list->destroy != NULL)
-            bytes_freed += list->destroy(tmp->value);
-
-        bytes_freed += sizeof(*tmp);
-        free(tmp);
-    }
-
-    bytes_freed += sizeof(*list);
-    free(list);
-    return bytes_freed;
+    const uint32_t k = chunk_of(pos);
+    return list->chunks[k][pos - chunks_capacity(k)];
 }
 
-// use the merge sort algorithm to sort the list - O(nlogn)
-// source: https://en.wikipedia.org/wiki/Merge_sort#Top-down_implementation_using_lists
+void* list_top_value(const List list)  { return list_get(list, list->size-1); }
 
-// split the list into two halves, placing the front part in front and the back part in back
-static inline void list_split(const list_node_ptr source, list_node_ptr* front, list_node_ptr* back)
+void list_push(const List list, void* value)
 {
-    // base case: list is empty or it has 1 element
-    if (source == NULL || source->next == NULL)
-    {
-        *back = NULL;
-        *front = source;
-        return;
-    } 
-
-    // use a s & f pointer to find the middle of the list and split it into two parts
-    list_node_ptr s = source, f = source->next;
-    while (f != NULL)
+    // every chunk is full, add the next one
+    if (list->size == chunks_capacity(list->chunks_num))
     {
-        f = f->next;
-        if (f != NULL)
+        list->chunks = realloc(list->chunks, (list->chunks_num+1) * sizeof(*list->chunks));
+        if (list->chunks == NULL)
         {
-            s = s->next;
-            f = f->next;
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
         }
+        list->chunks[list->chunks_num] = custom_malloc(chunk_size(list->chunks_num) * sizeof(void*));
+        list->chunks_num++;
     }
 
-    *back = s->next;
-    s->next = NULL;
-    *front = source;
+    const uint32_t k = chunk_of(list->size);
+    list->chunks[k][list->size - chunks_capacity(k)] = value;
+    list->size++;  // element was inserted
 }
 
-// recursively merge the lists l_list and r_list into one sorted list
-static list_node_ptr merge(const list_node_ptr l_list, const list_node_ptr r_list, const CompareFunc compare)
+void list_remove_at(const List list, const size_t pos)
 {
-    // the right list is empty, no need to compare, just return the left one
-    if (r_list == NULL) return l_list;
-
-    // the left list is empty, no need to compare, just return the right one
-    else if (l_list == NULL) return r_list;
-
-    // compare the two lists using the compare function
-    if (compare(l_list->value, r_list->value) > 0)
-    {
-        r_list->next = merge(l_list, r_list->next, compare);
-        return r_list;
-    }
-    else
+    // move the values back chunk by chunk, the first value of every chunk going to the end of the previous one
+    uint32_t k = chunk_of(pos);
+    size_t offset = pos - chunks_capacity(k);
+    while (true)
     {
-        l_list->next = merge(l_list->next, r_list, compare);
-        return l_list;
+        const size_t end = (list->size - chunks_capacity(k) < chunk_size(k))? list->size - chunks_capacity(k): chunk_size(k);
+        memmove(&list->chunks[k][offset], &list->chunks[k][offset+1], (end - offset - 1) * sizeof(void*));
+        if (chunks_capacity(k+1) >= list->size) break;
+
+        list->chunks[k][end-1] = list->chunks[k+1][0];
+        k++;
+        offset = 0;
     }
+    list->size--;
 }
 
-static void merge_sort(list_node_ptr* head, const CompareFunc compare)
+// copies the values of the list to the array, or the array to the list
+static void list_copy(const List list, void** array, const bool to_array)
 {
-    // base case: split operation can not continue: all elements are sorted
-    // const list_node_ptr curr = *head;
-    if (*head == NULL || (*head)->next == NULL) return;
-
-    // create two sub-lists and split them    
-    list_node_ptr left, right;
-    list_split(*head, &left, &right);
-
-    // after splitting is complete, merge the lists
-    merge_sort(&left, compare);
-    merge_sort(&right, compare);
-    *head = merge(left, right, compare);
+    for (uint32_t k = 0; k < list->chunks_num && chunks_capacity(k) < list->size; k++)
+    {
+        const size_t first = chunks_capacity(k);
+        const size_t n = (list->size - first < chunk_size(k))? list->size - first: chunk_size(k);
+        if (to_array) memcpy(&array[first], list->chunks[k], n * sizeof(void*));
+        else memcpy(list->chunks[k], &array[first], n * sizeof(void*));
+    }
 }
 
+// use the bottom-up merge sort algorithm to sort the list - O(nlogn), with no recursion
+// source: https://en.wikipedia.org/wiki/Merge_sort#Bottom-up_implementation
 void list_sort(const List list, const CompareFunc compare)
 {
-    // call merge sort to recursively sort the list
-    merge_sort(&list->top, compare);
-}
+    if (list->size < 2) return;
 
-//////////////////////////////////////////////////////
-// custom functions
-/////////////////////////////////////////////////////
+    // the values are sorted at an array and copied back
+    void** values = custom_malloc(list->size * sizeof(*values));
+    void** merged = custom_malloc(list->size * sizeof(*merged));
+    list_copy(list, values, true);
 
-postcode allocate_new_postcode(const int p)
-{
-    const postcode new_post = custom_malloc(sizeof(*new_post));
-    new_post->postcode = p;
-    new_post->voters = list_create(NULL);
-    return new_post;
-}
-
-void list_insert_postcode(const List list, const voter v)
-{
-    // check if the postcode already exists in the list
-    for (list_node_ptr tmp = list->top; tmp != NULL; tmp = tmp->next)
+    // merge every two neighbouring runs of the width, doubling it every pass
+    for (size_t width = 1; width < list->size; width *= 2)
     {
-        const postcode a = (postcode)tmp->value;
-        if (a->postcode == v->TK)
+        for (size_t left = 0; left < list->size; left += 2*width)
         {
-            list_push(a->voters, v);
-            return;
+            const size_t mid = (left + width < list->size)? left + width: list->size;
+            const size_t right = (mid + width < list->size)? mid + width: list->size;
+
+            // on equal values the left one goes first, so the sort is stable
+            size_t i = left, j = mid, pos = left;
+            while (i < mid && j < right)
+                merged[pos++] = (compare(values[i], values[j]) > 0)? values[j++]: values[i++];
+            while (i < mid) merged[pos++] = values[i++];
+            while (j < right) merged[pos++] = values[j++];
         }
+
+        void** tmp = values;
+        values = merged;
+        merged = tmp;
     }
 
-    // postcode does not exist, create it then insert it
-    list_push(list, allocate_new_postcode(v->TK));
-    const postcode a = (postcode)list_top_value(list);
-    list_push(a->voters, v);
+    list_copy(list, values, false);
+    free(values);
+    free(merged);
 }
 
-void print_zipcodes(const List list, const int zipcode)
+size_t list_bytes(const List list)
 {
-    // check if the postcode already exists in the list
-    for (list_node_ptr tmp = list->top; tmp != NULL; tmp = tmp->next)
-    {
-        const postcode a = (postcode)tmp->value;
-        if (a->postcode == zipcode)
-        {
-            // get the list of voters
-            const List zip_voters = a->voters;
-
-            printf("%ld voted in %d\n", list_size(zip_voters), zipcode);
-
-            // print the voters
-            for (list_node_ptr v_list = zip_voters->top; v_list != NULL; v_list = v_list->next)
-            {
-                const voter vot = v_list->value;
-                printf("%d\n", vot->PIN);
-            }
-            return;
-        }
-    }
-    printf("\n");
+    return sizeof(*list) + list->chunks_num * sizeof(*list->chunks) + chunks_capacity(list->chunks_num) * sizeof(void*);
 }
 
-void sorted_print(const List list)
+size_t list_destroy(const List list)
 {
-    for (list_node_ptr tmp = list->top; tmp != NULL; tmp = tmp->next)
+    size_t bytes_freed = list_bytes(list);
+
+    // if a destoy function was given destroy the data and count the bytes destroyed
+    if (list->destroy != NULL)
     {
-        const postcode a = (postcode)tmp->value;
-        printf("%d %ld\n", a->postcode, list_size(a->voters));
+        for (size_t i = 0; i < list->size; i++)
+            bytes_freed += list->destroy(list_get(list, i));
     }
-    printf("\n");
+
+    for (uint32_t k = 0; k < list->chunks_num; k++)
+        free(list->chunks[k]);
+    free(list->chunks);
+    free(list);
+    return bytes_freed;
 }
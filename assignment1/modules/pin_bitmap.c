@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../include/pin_bitmap.h"
+#include "../include/utilities.h"
+
+// the pins of a block & the words of a block
+#define BLOCK_PINS ((size_t)1 << BITMAP_BLOCK_BITS)
+#define BLOCK_WORDS (BLOCK_PINS / 64)
+
+typedef struct
+{
+    uint64_t words[BLOCK_WORDS];  // a bit per pin of the block
+}
+bitmap_block;
+
+// counts the bits set of consecutive words
+typedef size_t (*CountFunc)(const uint64_t*, const size_t);
+
+struct _pin_bitmap
+{
+    bitmap_block* blocks;    // the blocks, in the order they were created
+    uint32_t* indexes;       // the index of every block, its first pin >> BITMAP_BLOCK_BITS
+    size_t blocks_num;       // the number of blocks
+    size_t blocks_capacity;  // the capacity of the blocks & indexes arrays
+    uint32_t* slots;         // open addressing map of block index -> position in blocks + 1, 0 if empty
+    size_t slots_num;        // the number of slots of the map, a power of 2
+    size_t count;            // the number of bits set
+    CountFunc count_words;   // counts words with the popcount instruction if there is one
+};
+
+static size_t count_words(const uint64_t* words, const size_t n)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += __builtin_popcountll(words[i]);
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// the same, with the builtin compiled to the instruction
+__attribute__((target("popcnt"))) static size_t count_words_popcnt(const uint64_t* words, const size_t n)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += __builtin_popcountll(words[i]);
+    return count;
+}
+#endif
+
+// pins are mapped so that unsigned order is the signed order of the pins
+static inline uint32_t key_of(const int pin)
+{
+    return (uint32_t)pin ^ 0x80000000u;
+}
+
+// scramble the block index, so that neighbouring blocks do not crowd neighbouring slots
+static inline size_t block_hash(const uint32_t index)
+{
+    uint32_t x = index;
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x;
+}
+
+pin_bitmap bitmap_create(void)
+{
+    const pin_bitmap bitmap = custom_calloc(1, sizeof(*bitmap));
+    bitmap->slots_num = BITMAP_START_SLOTS;
+    bitmap->slots = custom_calloc(bitmap->slots_num, sizeof(*bitmap->slots));
+    bitmap->count_words = count_words;
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("popcnt")) bitmap->count_words = count_words_popcnt;
+#endif
+    return bitmap;
+}
+
+// returns the slot of the block index, or the empty slot it should be placed at
+static inline size_t block_slot(const pin_bitmap bitmap, const uint32_t index)
+{
+    const size_t mask = bitmap->slots_num - 1;
+    size_t slot = block_hash(index) & mask;
+
+    // linear probing
+    while (bitmap->slots[slot] != 0 && bitmap->indexes[bitmap->slots[slot]-1] != index)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// returns the block of the index, NULL if it was never set
+static inline bitmap_block* block_find(const pin_bitmap bitmap, const uint32_t index)
+{
+    const uint32_t pos = bitmap->slots[block_slot(bitmap, index)];
+    return (pos != 0)? &bitmap->blocks[pos-1]: NULL;
+}
+
+// double the slots of the map, keeping its load at most 1/2
+static void block_rehash(const pin_bitmap bitmap)
+{
+    free(bitmap->slots);
+    bitmap->slots_num *= 2;
+    bitmap->slots = custom_calloc(bitmap->slots_num, sizeof(*bitmap->slots));
+
+    for (size_t i = 0; i < bitmap->blocks_num; i++)
+        bitmap->slots[block_slot(bitmap, bitmap->indexes[i])] = i+1;
+}
+
+// returns the block of the index, creating it if it does not exist
+static bitmap_block* block_get(const pin_bitmap bitmap, const uint32_t index)
+{
+    size_t slot = block_slot(bitmap, index);
+    if (bitmap->slots[slot] != 0) return &bitmap->blocks[bitmap->slots[slot]-1];
+
+    if (2 * (bitmap->blocks_num+1) > bitmap->slots_num)
+    {
+        block_rehash(bitmap);
+        slot = block_slot(bitmap, index);
+    }
+
+    if (bitmap->blocks_num == bitmap->blocks_capacity)
+    {
+        bitmap->blocks_capacity = (bitmap->blocks_capacity == 0)? BITMAP_START_SLOTS: 2 * bitmap->blocks_capacity;
+        bitmap->blocks = realloc(bitmap->blocks, bitmap->blocks_capacity * sizeof(*bitmap->blocks));
+        bitmap->indexes = realloc(bitmap->indexes, bitmap->blocks_capacity * sizeof(*bitmap->indexes));
+        if (bitmap->blocks == NULL || bitmap->indexes == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bitmap_block* block = &bitmap->blocks[bitmap->blocks_num];
+    memset(block, 0, sizeof(*block));
+    bitmap->indexes[bitmap->blocks_num++] = index;
+    bitmap->slots[slot] = bitmap->blocks_num;
+    return block;
+}
+
+bool bitmap_set(const pin_bitmap bitmap, const int pin)
+{
+    const uint32_t key = key_of(pin);
+    bitmap_block* block = block_get(bitmap, key >> BITMAP_BLOCK_BITS);
+
+    uint64_t* word = &block->words[(key & (BLOCK_PINS-1)) / 64];
+    const uint64_t bit = 1ull << (key % 64);
+    if (*word & bit) return false;
+
+    *word |= bit;
+    bitmap->count++;
+    return true;
+}
+
+bool bitmap_clear(const pin_bitmap bitmap, const int pin)
+{
+    const uint32_t key = key_of(pin);
+    bitmap_block* block = block_find(bitmap, key >> BITMAP_BLOCK_BITS);
+    if (block == NULL) return false;
+
+    uint64_t* word = &block->words[(key & (BLOCK_PINS-1)) / 64];
+    const uint64_t bit = 1ull << (key % 64);
+    if (!(*word & bit)) return false;
+
+    // the block is kept, the pin is likely to be set again
+    *word &= ~bit;
+    bitmap->count--;
+    return true;
+}
+
+bool bitmap_test(const pin_bitmap bitmap, const int pin)
+{
+    const uint32_t key = key_of(pin);
+    const bitmap_block* block = block_find(bitmap, key >> BITMAP_BLOCK_BITS);
+    return block != NULL && (block->words[(key & (BLOCK_PINS-1)) / 64] >> (key % 64) & 1);
+}
+
+size_t bitmap_count(const pin_bitmap bitmap)  { return bitmap->count; }
+
+// counts the bits of the block from the first position to the last one, both included
+static size_t count_block(const pin_bitmap bitmap, const bitmap_block* block, const size_t first, const size_t last)
+{
+    const size_t first_word = first / 64, last_word = last / 64;
+    const uint64_t first_mask = ~0ull << (first % 64), last_mask = ~0ull >> (63 - last % 64);
+    if (first_word == last_word)
+        return __builtin_popcountll(block->words[first_word] & first_mask & last_mask);
+
+    return __builtin_popcountll(block->words[first_word] & first_mask) +
+           bitmap->count_words(&block->words[first_word+1], last_word - first_word - 1) +
+           __builtin_popcountll(block->words[last_word] & last_mask);
+}
+
+// counts the bits of the block of the index that are within the range of keys
+static inline size_t count_in_range(const pin_bitmap bitmap, const bitmap_block* block, const uint32_t index,
+                                    const uint32_t first, const uint32_t last)
+{
+    const uint32_t first_index = first >> BITMAP_BLOCK_BITS, last_index = last >> BITMAP_BLOCK_BITS;
+    return count_block(bitmap, block, (index == first_index)? first & (BLOCK_PINS-1): 0,
+                       (index == last_index)? last & (BLOCK_PINS-1): BLOCK_PINS-1);
+}
+
+size_t bitmap_count_range(const pin_bitmap bitmap, const int from, const int to)
+{
+    if (from > to) return 0;
+
+    const uint32_t first = key_of(from), last = key_of(to);
+    const uint32_t first_index = first >> BITMAP_BLOCK_BITS, last_index = last >> BITMAP_BLOCK_BITS;
+    size_t count = 0;
+
+    // look up every block of the range, unless there are fewer blocks than that to go through
+    if ((size_t)(last_index - first_index) < bitmap->blocks_num)
+    {
+        for (uint32_t index = first_index; ; index++)
+        {
+            const bitmap_block* block = block_find(bitmap, index);
+            if (block != NULL) count += count_in_range(bitmap, block, index, first, last);
+            if (index == last_index) break;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < bitmap->blocks_num; i++)
+        {
+            const uint32_t index = bitmap->indexes[i];
+            if (index >= first_index && index <= last_index)
+                count += count_in_range(bitmap, &bitmap->blocks[i], index, first, last);
+        }
+    }
+    return count;
+}
+
+// a saved bitmap starts with its sizes, followed by its blocks, their indexes and lastly the map
+typedef struct
+{
+    uint64_t count;       // the number of bits set
+    uint64_t blocks_num;  // the number of blocks
+    uint64_t slots_num;   // the number of slots of the map
+}
+saved_bitmap;
+
+bool bitmap_save(const pin_bitmap bitmap, FILE* file)
+{
+    const saved_bitmap header = { bitmap->count, bitmap->blocks_num, bitmap->slots_num };
+    return fwrite(&header, sizeof(header), 1, file) == 1 &&
+           fwrite(bitmap->blocks, sizeof(*bitmap->blocks), bitmap->blocks_num, file) == bitmap->blocks_num &&
+           fwrite(bitmap->indexes, sizeof(*bitmap->indexes), bitmap->blocks_num, file) == bitmap->blocks_num &&
+           fwrite(bitmap->slots, sizeof(*bitmap->slots), bitmap->slots_num, file) == bitmap->slots_num;
+}
+
+pin_bitmap bitmap_load(const void* saved)
+{
+    const saved_bitmap* header = saved;
+    const bitmap_block* blocks = (const bitmap_block*)(header + 1);
+    const uint32_t* indexes = (const uint32_t*)(blocks + header->blocks_num);
+    const uint32_t* slots = indexes + header->blocks_num;
+
+    // the arrays keep growing after the bitmap is loaded, so they are copied
+    const pin_bitmap bitmap = bitmap_create();
+    free(bitmap->slots);
+    bitmap->slots_num = header->slots_num;
+    bitmap->slots = custom_malloc(bitmap->slots_num * sizeof(*bitmap->slots));
+    memcpy(bitmap->slots, slots, bitmap->slots_num * sizeof(*bitmap->slots));
+
+    bitmap->count = header->count;
+    bitmap->blocks_num = bitmap->blocks_capacity = header->blocks_num;
+    if (bitmap->blocks_num > 0)
+    {
+        bitmap->blocks = custom_malloc(bitmap->blocks_num * sizeof(*bitmap->blocks));
+        bitmap->indexes = custom_malloc(bitmap->blocks_num * sizeof(*bitmap->indexes));
+        memcpy(bitmap->blocks, blocks, bitmap->blocks_num * sizeof(*bitmap->blocks));
+        memcpy(bitmap->indexes, indexes, bitmap->blocks_num * sizeof(*bitmap->indexes));
+    }
+    return bitmap;
+}
+
+size_t bitmap_bytes(const pin_bitmap bitmap)
+{
+    return sizeof(*bitmap) + bitmap->blocks_capacity * (sizeof(*bitmap->blocks) + sizeof(*bitmap->indexes)) +
+           bitmap->slots_num * sizeof(*bitmap->slots);
+}
+
+size_t bitmap_destroy(const pin_bitmap bitmap)
+{
+    const size_t bytes = bitmap_bytes(bitmap);
+    free(bitmap->blocks);
+    free(bitmap->indexes);
+    free(bitmap->slots);
+    free(bitmap);
+    return bytes;
+}
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../include/pin_index.h"
+#include "../include/utilities.h"
+#include "../include/arena.h"
+
+// the pins of a node come first, so searching a node only touches them
+typedef struct _pin_node
+{
+    int pins[PIN_NODE_KEYS];   // leaf: the pins of the participants, inner: the first pin of every child but the first
+    uint32_t pins_num;         // the number of pins
+    bool leaf;                 // whether the node is a leaf
+    union
+    {
+        struct
+        {
+            voter voters[PIN_NODE_KEYS];  // the participants, in the order of their pins
+            struct _pin_node* next;       // the leaf that follows, NULL for the last one
+        };
+        struct _pin_node* children[PIN_NODE_KEYS+1];  // the children, one more than the pins
+    };
+}
+pin_node;
+
+struct _pin_index
+{
+    pin_node* root;       // the root, a leaf while the index fits in one
+    size_t size;          // the number of participants at the tree
+    size_t nodes_num;     // the number of nodes
+    voter* pending;       // the participants inserted since the last query, not at the tree yet
+    size_t pending_num;   // the number of pending participants
+    size_t pending_capacity;  // the capacity of the pending array
+};
+
+static pin_node* node_create(const pin_index index, const bool leaf)
+{
+    pin_node* node = custom_calloc(1, sizeof(*node));
+    node->leaf = leaf;
+    index->nodes_num++;
+    return node;
+}
+
+static void node_destroy(pin_node* node)
+{
+    if (!node->leaf)
+    {
+        for (uint32_t i = 0; i <= node->pins_num; i++)
+            node_destroy(node->children[i]);
+    }
+    free(node);
+}
+
+// the number of pins of the node that are less than the pin
+static inline uint32_t lower_bound(const pin_node* node, const int pin)
+{
+    uint32_t low = 0, high = node->pins_num;
+    while (low < high)
+    {
+        const uint32_t mid = (low + high) / 2;
+        if (node->pins[mid] < pin) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// the number of pins of the node that are less than or equal to the pin, so the child the pin belongs to
+static inline uint32_t upper_bound(const pin_node* node, const int pin)
+{
+    uint32_t low = 0, high = node->pins_num;
+    while (low < high)
+    {
+        const uint32_t mid = (low + high) / 2;
+        if (node->pins[mid] <= pin) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+pin_index pindex_create(void)
+{
+    const pin_index index = custom_calloc(1, sizeof(*index));
+    index->root = node_create(index, true);
+    return index;
+}
+
+// splits the full child at the position of the parent, which is not full
+// a pin greater than every pin of the child goes to the right, which is then left with as little as possible,
+// so that pins inserted in ascending order fill their nodes instead of leaving them half empty
+// (and the other way around for a pin less than every pin of the child)
+static void split_child(const pin_index index, pin_node* parent, const uint32_t position, const int pin)
+{
+    pin_node* child = parent->children[position];
+    pin_node* right = node_create(index, child->leaf);
+    const bool append = (pin > child->pins[child->pins_num-1]), prepend = (pin < child->pins[0]);
+    int separator;
+
+    if (child->leaf)
+    {
+        // the right leaf starts at the separator
+        const uint32_t mid = append? PIN_NODE_KEYS-1: prepend? 1: PIN_NODE_KEYS/2;
+        right->pins_num = PIN_NODE_KEYS - mid;
+        memcpy(right->pins, &child->pins[mid], right->pins_num * sizeof(*right->pins));
+        memcpy(right->voters, &child->voters[mid], right->pins_num * sizeof(*right->voters));
+        child->pins_num = mid;
+
+        right->next = child->next;
+        child->next = right;
+        separator = right->pins[0];
+    }
+    else
+    {
+        // the separator moves up to the parent
+        const uint32_t mid = append? PIN_NODE_KEYS-1: prepend? 0: PIN_NODE_KEYS/2;
+        separator = child->pins[mid];
+        right->pins_num = PIN_NODE_KEYS - mid - 1;
+        memcpy(right->pins, &child->pins[mid+1], right->pins_num * sizeof(*right->pins));
+        memcpy(right->children, &child->children[mid+1], (right->pins_num + 1) * sizeof(*right->children));
+        child->pins_num = mid;
+    }
+
+    memmove(&parent->pins[position+1], &parent->pins[position], (parent->pins_num - position) * sizeof(*parent->pins));
+    memmove(&parent->children[position+2], &parent->children[position+1], (parent->pins_num - position) * sizeof(*parent->children));
+    parent->pins[position] = separator;
+    parent->children[position+1] = right;
+    parent->pins_num++;
+}
+
+// inserts the participant at the tree
+static void tree_insert(const pin_index index, const voter v)
+{
+    const int pin = v->PIN;
+
+    // full nodes are split on the way down, so there is always room for the separator of a split
+    if (index->root->pins_num == PIN_NODE_KEYS)
+    {
+        pin_node* root = node_create(index, false);
+        root->children[0] = index->root;
+        index->root = root;
+        split_child(index, root, 0, pin);
+    }
+
+    pin_node* node = index->root;
+    while (!node->leaf)
+    {
+        uint32_t position = upper_bound(node, pin);
+        if (node->children[position]->pins_num == PIN_NODE_KEYS)
+        {
+            split_child(index, node, position, pin);
+            if (pin >= node->pins[position]) position++;
+        }
+        node = node->children[position];
+    }
+
+    const uint32_t position = lower_bound(node, pin);
+    memmove(&node->pins[position+1], &node->pins[position], (node->pins_num - position) * sizeof(*node->pins));
+    memmove(&node->voters[position+1], &node->voters[position], (node->pins_num - position) * sizeof(*node->voters));
+    node->pins[position] = pin;
+    node->voters[position] = v;
+    node->pins_num++;
+    index->size++;
+}
+
+// the number of full leaves n participants are built into
+static inline size_t leaves_of(const size_t n)  { return (n + PIN_NODE_KEYS - 1) / PIN_NODE_KEYS; }
+
+// creates the leaves of n participants, linked in order and with their pins counted but not filled
+// they are placed at the level, which can hold leaves_of(n) nodes
+static void leaves_create(const pin_index index, pin_node** level, const size_t n)
+{
+    pin_node* previous = NULL;
+    for (size_t i = 0; i < leaves_of(n); i++)
+    {
+        pin_node* leaf = node_create(index, true);
+        leaf->pins_num = (n - i * PIN_NODE_KEYS < PIN_NODE_KEYS)? n - i * PIN_NODE_KEYS: PIN_NODE_KEYS;
+
+        if (previous != NULL) previous->next = leaf;
+        previous = leaf;
+        level[i] = leaf;
+    }
+}
+
+// builds the tree of n participants out of its filled leaves, from the leaves up, and frees the level
+static void tree_build_levels(const pin_index index, pin_node** level, const size_t n)
+{
+    size_t level_num = leaves_of(n);
+    int* first_pins = custom_malloc(level_num * sizeof(*first_pins));  // the least pin under every node of the level
+    for (size_t i = 0; i < level_num; i++) first_pins[i] = level[i]->pins[0];
+
+    // every level groups the nodes of the one below, until a single one is left
+    while (level_num > 1)
+    {
+        const size_t parents_num = (level_num + PIN_NODE_KEYS) / (PIN_NODE_KEYS + 1);
+        for (size_t i = 0; i < parents_num; i++)
+        {
+            pin_node* parent = node_create(index, false);
+            const size_t first = i * (PIN_NODE_KEYS + 1);
+            const size_t children = (level_num - first < PIN_NODE_KEYS + 1)? level_num - first: PIN_NODE_KEYS + 1;
+            for (size_t c = 0; c < children; c++)
+            {
+                parent->children[c] = level[first + c];
+                if (c > 0) parent->pins[c-1] = first_pins[first + c];
+            }
+            parent->pins_num = children - 1;
+
+            // the parents take the place of their first child, which was already read
+            first_pins[i] = first_pins[first];
+            level[i] = parent;
+        }
+        level_num = parents_num;
+    }
+
+    index->root = level[0];
+    index->size = n;
+    free(level);
+    free(first_pins);
+}
+
+// builds the tree out of participants sorted by pin, from its full leaves up
+static void tree_build(const pin_index index, const pin_entry* entries, const size_t n)
+{
+    pin_node** level = custom_malloc(leaves_of(n) * sizeof(*level));
+    leaves_create(index, level, n);
+    for (size_t i = 0; i < leaves_of(n); i++)
+    {
+        for (uint32_t j = 0; j < level[i]->pins_num; j++)
+        {
+            level[i]->voters[j] = entries[i * PIN_NODE_KEYS + j].v;
+            level[i]->pins[j] = level[i]->voters[j]->PIN;
+        }
+    }
+    tree_build_levels(index, level, n);
+}
+
+// moves the pending participants to the tree, in order of pin
+// an empty tree is built at once, otherwise consecutive inserts go down the same path
+static void pindex_flush(const pin_index index)
+{
+    if (index->pending_num == 0) return;
+
+    pin_entry* entries = custom_malloc(index->pending_num * sizeof(*entries));
+    pin_entry* tmp = custom_malloc(index->pending_num * sizeof(*tmp));
+    for (size_t i = 0; i < index->pending_num; i++)
+    {
+        entries[i].key = (uint32_t)index->pending[i]->PIN ^ 0x80000000u;
+        entries[i].v = index->pending[i];
+    }
+    radix_sort(&entries, &tmp, index->pending_num);
+
+    if (index->size == 0)
+    {
+        node_destroy(index->root);
+        index->nodes_num = 0;
+        tree_build(index, entries, index->pending_num);
+    }
+    else
+    {
+        for (size_t i = 0; i < index->pending_num; i++)
+            tree_insert(index, entries[i].v);
+    }
+
+    free(entries);
+    free(tmp);
+    index->pending_num = 0;
+
+    // the array a load of participants left behind is given back
+    if (index->pending_capacity > PIN_PENDING_START)
+    {
+        free(index->pending);
+        index->pending = NULL;
+        index->pending_capacity = 0;
+    }
+}
+
+void pindex_insert(const pin_index index, const voter v)
+{
+    if (index->pending_num == index->pending_capacity)
+    {
+        index->pending_capacity = (index->pending_capacity == 0)? PIN_PENDING_START: 2 * index->pending_capacity;
+        index->pending = realloc(index->pending, index->pending_capacity * sizeof(*index->pending));
+        if (index->pending == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    index->pending[index->pending_num++] = v;
+}
+
+// returns the leaf the pin belongs to
+static pin_node* find_leaf(const pin_index index, const int pin)
+{
+    pin_node* node = index->root;
+    while (!node->leaf) node = node->children[upper_bound(node, pin)];
+    return node;
+}
+
+bool pindex_remove(const pin_index index, const int pin)
+{
+    pindex_flush(index);
+    pin_node* leaf = find_leaf(index, pin);
+    const uint32_t position = lower_bound(leaf, pin);
+    if (position == leaf->pins_num || leaf->pins[position] != pin) return false;
+
+    // the separators above stay valid bounds, so nothing else changes
+    leaf->pins_num--;
+    memmove(&leaf->pins[position], &leaf->pins[position+1], (leaf->pins_num - position) * sizeof(*leaf->pins));
+    memmove(&leaf->voters[position], &leaf->voters[position+1], (leaf->pins_num - position) * sizeof(*leaf->voters));
+    index->size--;
+    return true;
+}
+
+void pindex_range(const pin_index index, const int from, const int to, const RangeFunc visit, void* arg)
+{
+    if (from > to) return;
+    pindex_flush(index);
+
+    // from the first pin of the range along the linked leaves, until a pin past it
+    pin_node* leaf = find_leaf(index, from);
+    for (uint32_t i = lower_bound(leaf, from); leaf != NULL; leaf = leaf->next, i = 0)
+    {
+        for (; i < leaf->pins_num; i++)
+        {
+            if (leaf->pins[i] > to) return;
+            visit(leaf->voters[i], arg);
+        }
+    }
+}
+
+size_t pindex_size(const pin_index index)  { return index->size + index->pending_num; }
+
+// a saved index is the number of its participants, followed by their pins and their positions, in order of pin
+bool pindex_save(const pin_index index, FILE* file, const voter_pool pool)
+{
+    pindex_flush(index);
+    const uint64_t size = index->size;
+    if (fwrite(&size, sizeof(size), 1, file) != 1) return false;
+
+    for (pin_node* leaf = find_leaf(index, INT_MIN); leaf != NULL; leaf = leaf->next)
+        if (fwrite(leaf->pins, sizeof(*leaf->pins), leaf->pins_num, file) != leaf->pins_num) return false;
+
+    for (pin_node* leaf = find_leaf(index, INT_MIN); leaf != NULL; leaf = leaf->next)
+    {
+        for (uint32_t i = 0; i < leaf->pins_num; i++)
+        {
+            const uint32_t position = pool_position(pool, leaf->voters[i]);
+            if (fwrite(&position, sizeof(position), 1, file) != 1) return false;
+        }
+    }
+    return true;
+}
+
+pin_index pindex_load(const void* saved, const voter voters)
+{
+    const uint64_t* size = saved;
+    const int* pins = (const int*)(size + 1);
+    const uint32_t* positions = (const uint32_t*)(pins + *size);
+
+    const pin_index index = pindex_create();
+    if (*size == 0) return index;
+
+    // the leaves are filled straight from the saved participants, no sorting takes place
+    node_destroy(index->root);
+    index->nodes_num = 0;
+    pin_node** level = custom_malloc(leaves_of(*size) * sizeof(*level));
+    leaves_create(index, level, *size);
+    for (size_t i = 0; i < leaves_of(*size); i++)
+    {
+        memcpy(level[i]->pins, &pins[i * PIN_NODE_KEYS], level[i]->pins_num * sizeof(*pins));
+        for (uint32_t j = 0; j < level[i]->pins_num; j++)
+            level[i]->voters[j] = &voters[positions[i * PIN_NODE_KEYS + j]];
+    }
+    tree_build_levels(index, level, *size);
+    return index;
+}
+
+size_t pindex_bytes(const pin_index index)
+{
+    return sizeof(*index) + index->nodes_num * sizeof(pin_node) + index->pending_capacity * sizeof(*index->pending);
+}
+
+size_t pindex_destroy(const pin_index index)
+{
+    const size_t bytes = pindex_bytes(index);
+    node_destroy(index->root);
+    free(index->pending);
+    free(index);
+    return bytes;
+}
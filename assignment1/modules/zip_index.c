@@ -0,0 +1,462 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/zip_index.h"
+#include "../include/utilities.h"
+#include "../include/arena.h"
+#include "../include/output.h"
+#include "../include/list.h"
+
+struct _zip_index
+{
+    struct _postcode_info* zips;  // the zipcodes, contiguous and in the order they were created
+    size_t zips_num;              // the number of zipcodes
+    size_t zips_capacity;         // the capacity of the zipcodes array
+    uint32_t* slots;              // open addressing map of zipcode -> position in zips + 1, 0 if empty
+    size_t slots_num;             // the number of slots of the map, a power of 2
+
+    // ranking of the zipcodes in descending order of voters, zipcodes with the same number of voters
+    // are next to each other so a zipcode moves up by swapping it with the first one of its count
+    uint32_t* ranking;            // positions in zips, ranked
+    size_t ranking_capacity;      // the capacity of the ranking array
+    size_t* first_ranked;         // the first position of the ranking with the given number of voters
+    size_t first_capacity;        // the capacity of the first ranked array
+};
+
+// scramble the zipcode, so that neighbouring zipcodes do not crowd neighbouring slots
+static inline size_t zip_hash(const int zipcode)
+{
+    uint32_t x = (uint32_t)zipcode;
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// grows an array to fit at least the given number of elements
+static void* grow_array(void* array, size_t* capacity, const size_t needed, const size_t element_size, const size_t start)
+{
+    if (needed <= *capacity) return array;
+
+    size_t new_capacity = (*capacity == 0)? start: *capacity;
+    while (new_capacity < needed) new_capacity *= 2;
+
+    array = realloc(array, new_capacity * element_size);
+    if (array == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed. Exiting..\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = new_capacity;
+    return array;
+}
+
+zip_index zip_create(void)
+{
+    const zip_index index = custom_calloc(1, sizeof(*index));
+    index->slots_num = ZIP_MAP_START_SLOTS;
+    index->slots = custom_calloc(index->slots_num, sizeof(*index->slots));
+    return index;
+}
+
+// returns the slot of the zipcode, or the empty slot it should be placed at
+static inline size_t zip_slot(const zip_index index, const int zipcode)
+{
+    const size_t mask = index->slots_num - 1;
+    size_t slot = zip_hash(zipcode) & mask;
+
+    // linear probing
+    while (index->slots[slot] != 0 && index->zips[index->slots[slot]-1].postcode != zipcode)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// double the slots of the map, keeping its load at most 1/2
+static void zip_rehash(const zip_index index)
+{
+    free(index->slots);
+    index->slots_num *= 2;
+    index->slots = custom_calloc(index->slots_num, sizeof(*index->slots));
+
+    for (size_t i = 0; i < index->zips_num; i++)
+        index->slots[zip_slot(index, index->zips[i].postcode)] = i+1;
+}
+
+postcode zip_find(const zip_index index, const int zipcode)
+{
+    const uint32_t pos = index->slots[zip_slot(index, zipcode)];
+    return (pos != 0)? &index->zips[pos-1]: NULL;
+}
+
+// the number of voters of the zipcode at the position of the ranking
+static inline size_t ranked_voters(const zip_index index, const size_t pos)
+{
+    return list_size(index->zips[index->ranking[pos]].voters);
+}
+
+// the zipcode at the position just got its number of voters
+// if it is the first one with that number, it starts the group of that number
+static inline void rank_joined(const zip_index index, const size_t pos)
+{
+    const size_t count = ranked_voters(index, pos);
+    index->first_ranked = grow_array(index->first_ranked, &index->first_capacity, count+1, sizeof(*index->first_ranked), ZIP_VOTERS_START);
+
+    if (pos == 0 || ranked_voters(index, pos-1) != count)
+        index->first_ranked[count] = pos;
+}
+
+// the zipcode got one more voter, move it in front of every zipcode with its previous count - O(1)
+static inline void rank_up(const zip_index index, const postcode zip)
+{
+    const size_t count = list_size(zip->voters)-1;  // the previous number of voters
+    const size_t first = index->first_ranked[count];
+
+    // swap the zipcode with the first one of its previous count
+    const postcode other = &index->zips[index->ranking[first]];
+    index->ranking[zip->rank] = index->ranking[first];
+    other->rank = zip->rank;
+    index->ranking[first] = zip - index->zips;
+    zip->rank = first;
+
+    // the group of the previous count now starts one position later
+    index->first_ranked[count] = first+1;
+    rank_joined(index, first);
+}
+
+// returns the zipcode, creating it if it does not exist
+static postcode zip_get(const zip_index index, const int zipcode)
+{
+    size_t slot = zip_slot(index, zipcode);
+    if (index->slots[slot] != 0) return &index->zips[index->slots[slot]-1];
+
+    // zipcode does not exist, create it
+    if (2 * (index->zips_num+1) > index->slots_num)
+    {
+        zip_rehash(index);
+        slot = zip_slot(index, zipcode);
+    }
+
+    index->zips = grow_array(index->zips, &index->zips_capacity, index->zips_num+1, sizeof(*index->zips), ZIP_MAP_START_SLOTS);
+    const postcode new_zip = &index->zips[index->zips_num++];
+    new_zip->postcode = zipcode;
+    new_zip->voters = list_create(NULL);
+    new_zip->participants = 0;
+
+    index->slots[slot] = index->zips_num;
+
+    // the new zipcode has no voters, so it is ranked last
+    index->ranking = grow_array(index->ranking, &index->ranking_capacity, index->zips_num, sizeof(*index->ranking), ZIP_MAP_START_SLOTS);
+    new_zip->rank = index->zips_num-1;
+    index->ranking[new_zip->rank] = new_zip->rank;
+    rank_joined(index, new_zip->rank);
+    return new_zip;
+}
+
+void zip_register(const zip_index index, const int zipcode)
+{
+    zip_get(index, zipcode)->participants++;
+}
+
+void zip_unregister(const zip_index index, const int zipcode)
+{
+    const postcode zip = zip_find(index, zipcode);
+    if (zip != NULL && zip->participants > 0) zip->participants--;
+}
+
+void zip_insert(const zip_index index, const voter v)
+{
+    const postcode zip = zip_get(index, v->TK);
+    list_push(zip->voters, v);
+    rank_up(index, zip);
+}
+
+// the zipcode lost a voter, move it behind every zipcode with its previous count
+// O(zipcodes with the previous count), since only the first position of every group is known
+static inline void rank_down(const zip_index index, const postcode zip)
+{
+    const size_t count = list_size(zip->voters)+1;  // the previous number of voters
+
+    // find the last zipcode of the previous count
+    size_t last = zip->rank;
+    while (last+1 < index->zips_num && ranked_voters(index, last+1) == count) last++;
+
+    // swap the zipcode with it
+    const postcode other = &index->zips[index->ranking[last]];
+    index->ranking[zip->rank] = index->ranking[last];
+    other->rank = zip->rank;
+    index->ranking[last] = zip - index->zips;
+    zip->rank = last;
+
+    // the zipcodes of the new count follow, so it is now the first one of them
+    index->first_ranked[list_size(zip->voters)] = last;
+}
+
+bool zip_remove(const zip_index index, const voter v)
+{
+    const postcode zip = zip_find(index, v->TK);
+    if (zip == NULL) return false;
+
+    size_t i = list_size(zip->voters);
+    while (i > 0 && list_get(zip->voters, i-1) != v) i--;
+    if (i == 0) return false;
+
+    // keep the rest of the voters in the order they voted
+    list_remove_at(zip->voters, i-1);
+    rank_down(index, zip);
+    return true;
+}
+
+size_t zip_size(const zip_index index)  { return index->zips_num; }
+
+void zip_print(const zip_index index, const int zipcode, const out_buffer out)
+{
+    const postcode zip = zip_find(index, zipcode);
+    if (zip == NULL || list_size(zip->voters) == 0)
+    {
+        out_string(out, "\n");
+        return;
+    }
+
+    out_printf(out, "%ld voted in %d\n", list_size(zip->voters), zipcode);
+
+    // print the voters, the most recent first
+    for (size_t i = list_size(zip->voters); i > 0; i--)
+    {
+        out_int(out, ((voter)list_get(zip->voters, i-1))->PIN);
+        out_string(out, "\n");
+    }
+}
+
+void zip_print_ranked(const zip_index index, const out_buffer out)
+{
+    zip_print_top(index, index->zips_num, out);
+}
+
+void zip_print_top(const zip_index index, const size_t k, const out_buffer out)
+{
+    for (size_t i = 0; i < index->zips_num && i < k && ranked_voters(index, i) > 0; i++)
+    {
+        const postcode zip = &index->zips[index->ranking[i]];
+        out_printf(out, "%d %ld\n", zip->postcode, list_size(zip->voters));
+    }
+    out_string(out, "\n");
+}
+
+// the zipcode along with its voters, its participants & the percentage of them that voted
+static void print_turnout(const postcode zip, const out_buffer out)
+{
+    const size_t voters = list_size(zip->voters);
+    out_printf(out, "%d %ld of %ld voted, %.3f\n", zip->postcode, voters, zip->participants, (float)voters / zip->participants * 100);
+}
+
+// whether the first zipcode has a higher turnout than the second, compared without dividing
+// ties go to the most voters and then to the least zipcode, so the order is the same every time
+static bool turnout_higher(const postcode a, const postcode b)
+{
+    const size_t a_voters = list_size(a->voters), b_voters = list_size(b->voters);
+    if (a_voters * b->participants != b_voters * a->participants)
+        return a_voters * b->participants > b_voters * a->participants;
+    if (a_voters != b_voters) return a_voters > b_voters;
+    return a->postcode < b->postcode;
+}
+
+// moves the zipcode at the position down the heap, the zipcode of the lowest turnout being at the top
+static void heap_down(postcode* heap, const size_t n, size_t pos)
+{
+    const postcode zip = heap[pos];
+    while (2*pos + 1 < n)
+    {
+        size_t child = 2*pos + 1;
+        if (child+1 < n && turnout_higher(heap[child], heap[child+1])) child++;
+        if (!turnout_higher(zip, heap[child])) break;
+
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = zip;
+}
+
+// moves the zipcode at the position up the heap
+static void heap_up(postcode* heap, size_t pos)
+{
+    const postcode zip = heap[pos];
+    while (pos > 0 && turnout_higher(heap[(pos-1) / 2], zip))
+    {
+        heap[pos] = heap[(pos-1) / 2];
+        pos = (pos-1) / 2;
+    }
+    heap[pos] = zip;
+}
+
+void zip_print_top_turnout(const zip_index index, const size_t k, const out_buffer out)
+{
+    const size_t capacity = (k < index->zips_num)? k: index->zips_num;
+    if (capacity == 0)
+    {
+        out_string(out, "\n");
+        return;
+    }
+
+    // keep the k highest turnouts seen so far, a zipcode only gets in by beating the lowest of them
+    postcode* heap = custom_malloc(capacity * sizeof(*heap));
+    size_t n = 0;
+    for (size_t i = 0; i < index->zips_num; i++)
+    {
+        const postcode zip = &index->zips[i];
+        if (zip->participants == 0) continue;
+
+        if (n < capacity)
+        {
+            heap[n] = zip;
+            heap_up(heap, n++);
+        }
+        else if (turnout_higher(zip, heap[0]))
+        {
+            heap[0] = zip;
+            heap_down(heap, n, 0);
+        }
+    }
+
+    // move the lowest turnout behind the rest until the heap is empty, which leaves them in descending order
+    for (size_t end = n; end > 1; end--)
+    {
+        const postcode lowest = heap[0];
+        heap[0] = heap[end-1];
+        heap[end-1] = lowest;
+        heap_down(heap, end-1, 0);
+    }
+
+    for (size_t i = 0; i < n; i++) print_turnout(heap[i], out);
+    out_string(out, "\n");
+    free(heap);
+}
+
+void zip_print_turnout(const zip_index index, const double min, const double max, const out_buffer out)
+{
+    for (size_t i = 0; i < index->zips_num; i++)
+    {
+        const postcode zip = &index->zips[index->ranking[i]];
+        if (zip->participants == 0) continue;
+
+        const double turnout = (double)list_size(zip->voters) / zip->participants * 100;
+        if (turnout >= min && turnout <= max) print_turnout(zip, out);
+    }
+    out_string(out, "\n");
+}
+
+// a saved index starts with its sizes, followed by its zipcodes, the first ranked position of every
+// number of voters, the map, the ranking and lastly the positions of the voters of every zipcode
+typedef struct
+{
+    uint64_t zips_num;   // the number of zipcodes
+    uint64_t slots_num;  // the number of slots of the map
+    uint64_t first_num;  // the number of first ranked positions saved
+    uint64_t voters;     // the number of voters of every zipcode together
+}
+saved_index;
+
+typedef struct
+{
+    int32_t postcode;
+    uint32_t voters_num;
+    uint64_t rank;
+    uint64_t participants;
+}
+saved_zip;
+
+bool zip_save(const zip_index index, FILE* file, const voter_pool pool)
+{
+    // the group of the most voters is the last one that can be used
+    saved_index header = { index->zips_num, index->slots_num, 0, 0 };
+    if (index->zips_num > 0) header.first_num = ranked_voters(index, 0) + 1;
+    for (size_t i = 0; i < index->zips_num; i++) header.voters += list_size(index->zips[i].voters);
+    if (fwrite(&header, sizeof(header), 1, file) != 1) return false;
+
+    for (size_t i = 0; i < index->zips_num; i++)
+    {
+        const saved_zip zip = { index->zips[i].postcode, (uint32_t)list_size(index->zips[i].voters), index->zips[i].rank,
+                                index->zips[i].participants };
+        if (fwrite(&zip, sizeof(zip), 1, file) != 1) return false;
+    }
+
+    for (size_t i = 0; i < header.first_num; i++)
+    {
+        const uint64_t first = index->first_ranked[i];
+        if (fwrite(&first, sizeof(first), 1, file) != 1) return false;
+    }
+
+    if (fwrite(index->slots, sizeof(*index->slots), index->slots_num, file) != index->slots_num ||
+        fwrite(index->ranking, sizeof(*index->ranking), index->zips_num, file) != index->zips_num)
+        return false;
+
+    for (size_t i = 0; i < index->zips_num; i++)
+    {
+        for (size_t j = 0; j < list_size(index->zips[i].voters); j++)
+        {
+            const uint32_t position = pool_position(pool, list_get(index->zips[i].voters, j));
+            if (fwrite(&position, sizeof(position), 1, file) != 1) return false;
+        }
+    }
+    return true;
+}
+
+zip_index zip_load(const void* saved, const voter voters)
+{
+    const saved_index* header = saved;
+    const saved_zip* zips = (const saved_zip*)(header + 1);
+    const uint64_t* first_ranked = (const uint64_t*)(zips + header->zips_num);
+    const uint32_t* slots = (const uint32_t*)(first_ranked + header->first_num);
+    const uint32_t* ranking = slots + header->slots_num;
+    const uint32_t* positions = ranking + header->zips_num;
+
+    const zip_index index = custom_calloc(1, sizeof(*index));
+
+    // the arrays keep growing after the index is loaded, so they are copied
+    index->slots_num = header->slots_num;
+    index->slots = custom_malloc(index->slots_num * sizeof(*index->slots));
+    memcpy(index->slots, slots, index->slots_num * sizeof(*index->slots));
+
+    index->zips = grow_array(NULL, &index->zips_capacity, header->zips_num, sizeof(*index->zips), ZIP_MAP_START_SLOTS);
+    index->ranking = grow_array(NULL, &index->ranking_capacity, header->zips_num, sizeof(*index->ranking), ZIP_MAP_START_SLOTS);
+    index->first_ranked = grow_array(NULL, &index->first_capacity, header->first_num, sizeof(*index->first_ranked), ZIP_VOTERS_START);
+    index->zips_num = header->zips_num;
+    if (header->zips_num > 0) memcpy(index->ranking, ranking, header->zips_num * sizeof(*index->ranking));
+    for (size_t i = 0; i < header->first_num; i++) index->first_ranked[i] = first_ranked[i];
+
+    for (size_t i = 0; i < header->zips_num; i++)
+    {
+        const postcode zip = &index->zips[i];
+        zip->postcode = zips[i].postcode;
+        zip->rank = zips[i].rank;
+        zip->participants = zips[i].participants;
+        zip->voters = list_create(NULL);
+
+        for (size_t j = 0; j < zips[i].voters_num; j++)
+            list_push(zip->voters, &voters[*positions++]);
+    }
+    return index;
+}
+
+size_t zip_bytes(const zip_index index)
+{
+    size_t bytes = sizeof(*index);
+    for (size_t i = 0; i < index->zips_num; i++)
+        bytes += list_bytes(index->zips[i].voters);
+
+    return bytes + index->zips_capacity * sizeof(*index->zips) + index->slots_num * sizeof(*index->slots) +
+           index->ranking_capacity * sizeof(*index->ranking) + index->first_capacity * sizeof(*index->first_ranked);
+}
+
+size_t zip_destroy(const zip_index index)
+{
+    const size_t bytes = zip_bytes(index);
+    for (size_t i = 0; i < index->zips_num; i++)
+        list_destroy(index->zips[i].voters);
+
+    free(index->zips);
+    free(index->slots);
+    free(index->ranking);
+    free(index->first_ranked);
+    free(index);
+    return bytes;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../include/batch.h"
+#include "../include/commands.h"
+#include "../include/output.h"
+#include "../include/utilities.h"
+
+// writes everything the buffer gathered to the file descriptor
+static void write_all(const out_buffer out, const int fd)
+{
+    while (out_size(out) > 0)
+    {
+        const ssize_t n = write(fd, out_data(out), out_size(out));
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) break;  // nobody reads it anymore
+        out_consume(out, n);
+    }
+    out_consume(out, out_size(out));
+}
+
+// writes the responses & the errors gathered so far
+static void write_block(const out_buffer out, const out_buffer err)
+{
+    write_all(out, STDOUT_FILENO);
+    write_all(err, STDERR_FILENO);
+}
+
+// runs a line of the block, returns true if it was exit
+// consecutive l & m lines are gathered to the group, which is run before any other line responds
+static bool batch_line(const database db, const command_group group, char* line)
+{
+    // an empty line is reported by read_command at once, so the group goes first
+    command_preprocess(line);
+    if (line[0] == '\0' && !group_empty(group)) group_run(db, group);
+
+    const command_t command_n = read_command(line);
+    if (command_n == FIND_PIN || command_n == VOTED)
+    {
+        group_add(db, group, command_n);
+        return false;
+    }
+
+    if (!group_empty(group)) group_run(db, group);
+    if (command_n == EXIT) return true;
+
+    run_command(db, command_n);
+    return false;
+}
+
+void batch_run(const database db)
+{
+    // one more byte, to terminate a last line with no newline
+    char* block = custom_malloc(BATCH_BLOCK_SIZE + 1);
+    size_t used = 0;
+    bool discarding = false;  // the rest of a line too long to be run is being dropped
+    bool done = false;
+
+    const command_group group = group_create();
+    const out_buffer out = out_create(NULL, BATCH_BLOCK_SIZE);
+    const out_buffer err = out_create(NULL, OUT_BUFFER_SIZE);
+    out_flush_std();
+    out_redirect(out, err);
+
+    while (!done)
+    {
+        const ssize_t n = read(STDIN_FILENO, block + used, BATCH_BLOCK_SIZE - used);
+        if (n == -1 && errno == EINTR) continue;
+
+        // with stdin over, what is left is the last line even if it has no newline
+        const bool last = (n <= 0);
+        if (n > 0) used += n;
+
+        size_t start = 0;
+        while (!done && start < used)
+        {
+            char* line = block + start;
+            char* newline = memchr(line, '\n', used - start);
+            if (newline == NULL && !last) break;
+
+            const size_t length = (newline != NULL)? (size_t)(newline - line): used - start;
+            line[length] = '\0';
+            if (discarding)  // the end of a line too long
+                discarding = false;
+            else if (length >= BUFFER_SIZE)
+            {
+                if (!group_empty(group)) group_run(db, group);
+                unsuccessful_response("Malformed Input");
+            }
+            else
+                done = batch_line(db, group, line);
+            start += length + 1;
+        }
+
+        // a line that fills the whole block can never be run, drop it until its end
+        if (!group_empty(group)) group_run(db, group);
+        if (start == 0 && used == BATCH_BLOCK_SIZE)
+        {
+            if (!discarding) unsuccessful_response("Malformed Input");
+            discarding = true;
+            used = 0;
+        }
+        else if (start < used)
+        {
+            memmove(block, block + start, used - start);
+            used -= start;
+        }
+        else
+            used = 0;
+
+        write_block(out, err);
+        if (last) break;
+    }
+
+    out_redirect(NULL, NULL);
+    out_destroy(out);
+    out_destroy(err);
+    group_destroy(group);
+    free(block);
+}
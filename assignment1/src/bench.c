@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/utilities.h"
+#include "../include/database.h"
+#include "../include/linear_hashing.h"
+#include "../include/hash_functions.h"
+#include "../include/zip_index.h"
+#include "../include/ingest.h"
+#include "../include/arena.h"
+#include "../include/output.h"
+
+// throughput & latency of the operations of mvote, at every combination of the settings given
+// every voters file is loaded once per combination, and then its voters are
+// inserted one by one, looked up at random, half of them marked as voted,
+// the voters of random zipcodes printed (z) and the zipcodes ranked (o)
+// a csv line is printed per file, combination & operation
+// usage: ./mvote_bench -f <files> -b <bucket sizes> -m <starting sizes> -e <expand functions>
+//                -h <hash> -l <lookups> -z <z commands> -r <o commands>
+// every list is separated by commas, e.g. -b 1,4,16
+
+#define DEFAULT_LOOKUPS 1000000
+#define DEFAULT_ZIP_QUERIES 1000
+#define DEFAULT_RANKINGS 100
+
+// the most values a list of settings can have
+#define MAX_SETTINGS 16
+
+// cheap operations are timed one in that many, so the clock does not weigh on the throughput
+#define SAMPLE_EVERY 16
+
+typedef struct
+{
+    uint64_t* samples;      // the latencies sampled, in nanoseconds
+    size_t samples_num;     // the number of samples
+    size_t ops;             // the operations made
+    struct timespec start;  // when the operations started
+    double seconds;         // the time all of the operations took
+    size_t every;           // one operation in that many is sampled
+}
+timer;
+
+static inline uint64_t xorshift(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static inline uint64_t nanoseconds(const struct timespec* t)
+{
+    return (uint64_t)t->tv_sec * 1000000000ull + t->tv_nsec;
+}
+
+static void timer_start(timer* t, const size_t ops, const size_t every)
+{
+    t->every = every;
+    t->ops = ops;
+    t->samples_num = 0;
+    t->samples = custom_malloc((ops / every + 1) * sizeof(*t->samples));
+    clock_gettime(CLOCK_MONOTONIC, &t->start);
+}
+
+static void timer_stop(timer* t)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    t->seconds = (nanoseconds(&end) - nanoseconds(&t->start)) / 1e9;
+}
+
+static int compare_samples(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// the sample below which the given fraction of the samples fall
+static uint64_t percentile(const timer* t, const double fraction)
+{
+    if (t->samples_num == 0) return 0;
+    return t->samples[(size_t)(fraction * (t->samples_num - 1))];
+}
+
+// prints the csv line of an operation and frees the samples of its timer
+static void report(const char* file, const int bucket_size, const int starting_size, const int expand_func,
+                   const char* operation, timer* t)
+{
+    qsort(t->samples, t->samples_num, sizeof(*t->samples), compare_samples);
+    printf("%s,%d,%d,%d,%s,%ld,%.6f,%.3f,%lu,%lu,%lu,%lu\n", file, bucket_size, starting_size, expand_func,
+           operation, t->ops, t->seconds, (t->seconds > 0)? t->ops / t->seconds / 1e6: 0,
+           percentile(t, 0.5), percentile(t, 0.9), percentile(t, 0.99), percentile(t, 1));
+    free(t->samples);
+}
+
+// times the statement, for one in every so many operations
+#define TIMED(t, i, statement)                                                         \
+    do {                                                                               \
+        if ((i) % (t).every == 0)                                                      \
+        {                                                                              \
+            struct timespec from, to;                                                  \
+            clock_gettime(CLOCK_MONOTONIC, &from);                                     \
+            statement;                                                                 \
+            clock_gettime(CLOCK_MONOTONIC, &to);                                       \
+            (t).samples[(t).samples_num++] = nanoseconds(&to) - nanoseconds(&from);    \
+        }                                                                              \
+        else statement;                                                                \
+    } while (0)
+
+typedef struct
+{
+    const char* files[MAX_SETTINGS];
+    int bucket_sizes[MAX_SETTINGS];
+    int starting_sizes[MAX_SETTINGS];
+    int expand_funcs[MAX_SETTINGS];
+    int files_num, bucket_sizes_num, starting_sizes_num, expand_funcs_num;
+    int hash_func;
+    int lookups, zip_queries, rankings;
+}
+settings;
+
+// runs every operation at one combination of the settings
+// returns false if the voters file could not be read
+static bool bench_one(const settings* s, const char* file, const int bucket_size, const int starting_size, const int expand_func)
+{
+    const voter_pool pool = pool_create();
+    const string_arena strings = arena_create();
+    size_t voters_num;
+    voter* voters = ingest_file(file, 1, pool, strings, &voters_num);
+    if (voters == NULL)
+    {
+        pool_destroy(pool);
+        arena_destroy(strings);
+        return false;
+    }
+    const database db = db_create(bucket_size, starting_size, expand_func, s->hash_func, pool, strings);
+
+    // the pins & zipcodes are kept, the duplicates being released at the insertions
+    int* pins = custom_malloc((voters_num + 1) * sizeof(*pins));
+    int* zips = custom_malloc((voters_num + 1) * sizeof(*zips));
+    for (size_t i = 0; i < voters_num; i++)
+    {
+        pins[i] = voters[i]->PIN;
+        zips[i] = voters[i]->TK;
+    }
+
+    timer t;
+    timer_start(&t, voters_num, SAMPLE_EVERY);
+    for (size_t i = 0; i < voters_num; i++)
+        TIMED(t, i, if (!db_participant_insert(db, voters[i])) pool_release(pool, voters[i]));
+    timer_stop(&t);
+    report(file, bucket_size, starting_size, expand_func, "insert", &t);
+    free(voters);
+
+    size_t found = 0;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    const size_t lookups = (voters_num > 0)? (size_t)s->lookups: 0;
+    timer_start(&t, lookups, SAMPLE_EVERY);
+    for (size_t i = 0; i < lookups; i++)
+        TIMED(t, i, found += (db_search(db, pins[xorshift(&state) % voters_num]) != NULL));
+    timer_stop(&t);
+    if (found != lookups) fprintf(stderr, "%ld of %ld lookups failed\n", lookups - found, lookups);
+    report(file, bucket_size, starting_size, expand_func, "lookup", &t);
+
+    // the first half of the pins, in a random order
+    const size_t marks = voters_num / 2;
+    for (size_t i = marks; i > 1; i--)
+    {
+        const size_t j = xorshift(&state) % i;
+        const int pin = pins[i - 1];
+        pins[i - 1] = pins[j];
+        pins[j] = pin;
+    }
+    timer_start(&t, marks, SAMPLE_EVERY);
+    for (size_t i = 0; i < marks; i++)
+        TIMED(t, i, db_mark_voted(db, pins[i]));
+    timer_stop(&t);
+    report(file, bucket_size, starting_size, expand_func, "mark_voted", &t);
+
+    // the output of z & o is gathered in memory and dropped, only the commands are timed
+    const out_buffer out = out_create(NULL, OUT_BUFFER_SIZE);
+    const size_t zip_queries = (voters_num > 0)? (size_t)s->zip_queries: 0;
+    timer_start(&t, zip_queries, 1);
+    for (size_t i = 0; i < zip_queries; i++)
+    {
+        TIMED(t, i, zip_print(db->zips, zips[xorshift(&state) % voters_num], out));
+        out_consume(out, out_size(out));
+    }
+    timer_stop(&t);
+    report(file, bucket_size, starting_size, expand_func, "z", &t);
+
+    timer_start(&t, s->rankings, 1);
+    for (size_t i = 0; i < (size_t)s->rankings; i++)
+    {
+        TIMED(t, i, zip_print_ranked(db->zips, out));
+        out_consume(out, out_size(out));
+    }
+    timer_stop(&t);
+    report(file, bucket_size, starting_size, expand_func, "o", &t);
+
+    out_destroy(out);
+    free(pins);
+    free(zips);
+    db_close(db);
+    return true;
+}
+
+// reads a list of numbers separated by commas, returns how many were read
+static int read_list(char* str, int* values)
+{
+    int n = 0;
+    for (char* token = strtok(str, ","); token != NULL && n < MAX_SETTINGS; token = strtok(NULL, ","))
+        if ((values[n] = string_to_int(token)) > 0) n++;
+    return n;
+}
+
+int main(int argc, char* argv[])
+{
+    settings s = { .hash_func = DEFAULT_HASH_FUNC, .lookups = DEFAULT_LOOKUPS,
+                   .zip_queries = DEFAULT_ZIP_QUERIES, .rankings = DEFAULT_RANKINGS };
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], "-f") == 0)
+        {
+            for (char* token = strtok(argv[i+1], ","); token != NULL && s.files_num < MAX_SETTINGS; token = strtok(NULL, ","))
+                s.files[s.files_num++] = token;
+        }
+        else if (strcmp(argv[i], "-b") == 0) s.bucket_sizes_num = read_list(argv[i+1], s.bucket_sizes);
+        else if (strcmp(argv[i], "-m") == 0) s.starting_sizes_num = read_list(argv[i+1], s.starting_sizes);
+        else if (strcmp(argv[i], "-e") == 0) s.expand_funcs_num = read_list(argv[i+1], s.expand_funcs);
+        else if (strcmp(argv[i], "-h") == 0) s.hash_func = hash_kind_of(argv[i+1]);
+        else if (strcmp(argv[i], "-l") == 0) s.lookups = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-z") == 0) s.zip_queries = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-r") == 0) s.rankings = string_to_int(argv[i+1]);
+    }
+    if (s.files_num == 0)
+    {
+        fprintf(stderr, "No voters file was given\n");
+        return EXIT_FAILURE;
+    }
+    if (s.hash_func == HASH_FUNCS_NUM || hash_function(s.hash_func) == NULL) s.hash_func = DEFAULT_HASH_FUNC;
+    if (s.bucket_sizes_num == 0) s.bucket_sizes[s.bucket_sizes_num++] = DEFAULT_BUCKET_SIZE;
+    if (s.starting_sizes_num == 0) s.starting_sizes[s.starting_sizes_num++] = DEFAULT_ST_CAPACITY;
+    if (s.expand_funcs_num == 0) s.expand_funcs[s.expand_funcs_num++] = DEFAULT_EXPAND_FUNC;
+    if (s.lookups < 0) s.lookups = DEFAULT_LOOKUPS;
+    if (s.zip_queries < 0) s.zip_queries = DEFAULT_ZIP_QUERIES;
+    if (s.rankings < 0) s.rankings = DEFAULT_RANKINGS;
+
+    printf("file,bucket_size,starting_size,expand,operation,ops,seconds,mops_per_s,p50_ns,p90_ns,p99_ns,max_ns\n");
+    for (int f = 0; f < s.files_num; f++)
+        for (int b = 0; b < s.bucket_sizes_num; b++)
+            for (int m = 0; m < s.starting_sizes_num; m++)
+                for (int e = 0; e < s.expand_funcs_num; e++)
+                {
+                    if (!bench_one(&s, s.files[f], s.bucket_sizes[b], s.starting_sizes[m], s.expand_funcs[e]))
+                    {
+                        fprintf(stderr, "%s could not be read\n", s.files[f]);
+                        return EXIT_FAILURE;
+                    }
+                    fflush(stdout);
+                }
+    return EXIT_SUCCESS;
+}
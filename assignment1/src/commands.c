@@ -3,25 +3,44 @@
 #include <string.h>
 #include "../include/commands.h"
 #include "../include/utilities.h"
-#include "../include/list.h"
+#include "../include/zip_index.h"
 #include "../include/database.h"
+#include "../include/output.h"
+#include "../include/stats.h"
 
-// 1 - l <pin>
-void find_participant(const database db)
+// gets the pins that follow the command, a malformed pin is set to -1
+// with no pins at all, a single malformed one is returned
+static size_t command_pins(int* pins)
+{
+    size_t pins_num = 0;
+    for (char* p = strtok(NULL, " "); p != NULL && pins_num < MAX_COMMAND_PINS; p = strtok(NULL, " "))
+        pins[pins_num++] = string_to_int(p);
+
+    if (pins_num == 0) pins[pins_num++] = -1;
+    return pins_num;
+}
+
+// the response of l to a pin, along with the participant found with it
+static void find_response(const database db, const int pin, const voter v)
 {
-    char* p = strtok(NULL, " ");
-    const int pin = string_to_int(p);
     if (pin == -1)
-    {
         unsuccessful_response("Malformed Pin");
-        return;
-    }
-    
-    const voter v = hash_search(db->ht, pin); 
-    if (v != NULL)  // found
-        printf("%d %s %s %d %c\n\n", v->PIN, v->surname, v->name, v->TK, v->voted);
+    else if (v != NULL)  // found
+        out_printf(responses(), "%d %s %s %d %c\n\n", v->PIN, voter_surname(db, v), voter_name(db, v), v->TK, v->voted);
     else
-        fprintf(stderr, "Participant %d not in cohort\n\n", pin);
+        out_printf(errors(), "Participant %d not in cohort\n\n", pin);
+}
+
+// 1 - l <pin> [<pin> ...]
+void find_participant(const database db)
+{
+    int pins[MAX_COMMAND_PINS];
+    voter found[MAX_COMMAND_PINS];
+    const size_t pins_num = command_pins(pins);
+    db_search_many(db, pins, pins_num, found);
+
+    for (size_t i = 0; i < pins_num; i++)
+        find_response(db, pins[i], found[i]);
 }
 
 // 2 - i <pin> <lname> <fname> <zip>
@@ -39,25 +58,17 @@ void insert_participant(const database db)
     }
 
     // lname
-    p = strtok(NULL, " ");
-    if (check_malformed(p)) return;
-    char* surname = mystrcpy(p);
+    const char* surname = strtok(NULL, " ");
+    if (check_malformed(surname)) return;
 
     // fname
-    p = strtok(NULL, " ");
-    if (check_malformed(p)) return;
-
-    char* name = mystrcpy(p);
+    const char* name = strtok(NULL, " ");
+    if (check_malformed(name)) return;
 
     // zip
     p = strtok(NULL, " ");
-    if (p == NULL)
-    {
-        free(surname);
-        free(name);
-        unsuccessful_response("Malformed Input");
-        return;
-    }
+    if (check_malformed(p)) return;
+
     const int zip = string_to_int(p);
     if (zip == -1)
     {
@@ -65,93 +76,290 @@ void insert_participant(const database db)
         return;
     }
 
-    if (db_participant_insert(db, create_voter(name, surname, pin, zip)))
-        printf("Inserted %d %s %s %d %c\n\n", pin, surname, name, zip, 'N');
-    else
-        fprintf(stderr, "%d already exist\n\n", pin);
+    if (!db_add_participant(db, pin, surname, name, zip))
+    {
+        out_printf(errors(), "%d already exist\n\n", pin);
+        return;
+    }
+    out_printf(responses(), "Inserted %d %s %s %d %c\n\n", pin, surname, name, zip, 'N');
 }
 
-// 3 - m <pin>
-void mark_voted(const database db)
+// 13 - d <pin>
+void delete_participant(const database db)
 {
-    char* p = strtok(NULL, " ");
+    const char* p = strtok(NULL, " ");
+    if (check_malformed(p)) return;
+
     const int pin = string_to_int(p);
     if (pin == -1)
     {
         unsuccessful_response("Malformed Input");
         return;
     }
-    
-    // find the voter
-    const voter v = hash_search(db->ht, pin);
-    if (v != NULL)  // voter found
+
+    if (!db_remove(db, pin))
+    {
+        out_printf(errors(), "%d does not exist\n\n", pin);
+        return;
+    }
+    out_printf(responses(), "Deleted %d\n\n", pin);
+}
+
+// the response of m to a pin, along with the participant found with it
+static void mark_response(const database db, const int pin, const voter v)
+{
+    if (pin == -1)
+        unsuccessful_response("Malformed Input");
+    else if (v != NULL)  // voter found
     {
         if (v->voted == 'y')
             unsuccessful_response("Participant already voted");
         else
         {
             db_insert_voter(db, v);
-            printf("%d Mark Voted\n\n", pin);
+            out_printf(responses(), "%d Mark Voted\n\n", pin);
         }
     }
     else  // participant does not exist in the database
-        fprintf(stderr, "%d does not exist\n\n", pin);
+        out_printf(errors(), "%d does not exist\n\n", pin);
 }
 
-// 4 - bv <file>
+// 3 - m <pin> [<pin> ...]
+void mark_voted(const database db)
+{
+    int pins[MAX_COMMAND_PINS];
+    voter found[MAX_COMMAND_PINS];
+    const size_t pins_num = command_pins(pins);
+    db_search_many(db, pins, pins_num, found);
+
+    for (size_t i = 0; i < pins_num; i++)
+        mark_response(db, pins[i], found[i]);
+}
+
+struct _command_group
+{
+    int pins[COMMAND_GROUP_PINS];         // the pins of every command, one command after the other
+    voter found[COMMAND_GROUP_PINS];      // the participant found with every pin
+    command_t commands[COMMAND_GROUP_PINS];  // the commands, every one has at least a pin
+    uint32_t pins_num[COMMAND_GROUP_PINS];   // the number of pins of every command
+    size_t commands_num;                  // the number of commands
+    size_t total_pins;                    // the number of pins of every command together
+};
+
+command_group group_create(void)
+{
+    return custom_calloc(1, sizeof(struct _command_group));
+}
+
+bool group_empty(const command_group group)  { return group->commands_num == 0; }
+
+void group_add(const database db, const command_group group, const command_t command_n)
+{
+    // a command has at most MAX_COMMAND_PINS pins, make sure they fit
+    if (group->total_pins + MAX_COMMAND_PINS > COMMAND_GROUP_PINS) group_run(db, group);
+
+    const size_t pins_num = command_pins(&group->pins[group->total_pins]);
+    group->commands[group->commands_num] = command_n;
+    group->pins_num[group->commands_num++] = pins_num;
+    group->total_pins += pins_num;
+}
+
+void group_run(const database db, const command_group group)
+{
+    // voters stay where they are once found, so a vote of a command is seen by the ones after it
+    db_search_many(db, group->pins, group->total_pins, group->found);
+
+    size_t pin = 0;
+    for (size_t i = 0; i < group->commands_num; i++)
+    {
+        for (uint32_t j = 0; j < group->pins_num[i]; j++, pin++)
+        {
+            if (group->commands[i] == FIND_PIN) find_response(db, group->pins[pin], group->found[pin]);
+            else mark_response(db, group->pins[pin], group->found[pin]);
+        }
+    }
+    group->commands_num = group->total_pins = 0;
+}
+
+void group_destroy(const command_group group)
+{
+    free(group);
+}
+
+// gets the pin of every line of the file, reporting lines with a malformed pin
+// returns the pins and sets their number
+static int* parse_pins(const char* file, const size_t size, size_t* pins_num, size_t* malformed, const out_buffer err)
+{
+    size_t capacity = DEFAULT_BULK_CAPACITY;
+    int* pins = custom_malloc(capacity * sizeof(*pins));
+    *pins_num = 0;
+
+    const char* const end = file + size;
+    for (const char* line = file; line < end; )
+    {
+        const char* newline = memchr(line, '\n', end - line);
+        const char* line_end = (newline != NULL)? newline: end;
+
+        // the pin is the first word of the line
+        const char* p = line;
+        while (p < line_end && *p == ' ') p++;
+        const char* space = memchr(p, ' ', line_end - p);
+        const char* pin_end = (space != NULL)? space: line_end;
+        line = line_end + 1;
+
+        if (p == line_end) continue;  // empty line
+
+        const int pin = string_n_to_int(p, pin_end - p);
+        if (pin == -1)
+        {
+            (*malformed)++;
+            if (err != NULL) out_string(err, "Malformed Input\n\n");
+            continue;
+        }
+
+        if (*pins_num == capacity)
+        {
+            capacity *= 2;
+            pins = realloc(pins, capacity * sizeof(*pins));
+            if (pins == NULL)
+            {
+                fprintf(stderr, "Memory allocation failed. Exiting..\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        pins[(*pins_num)++] = pin;
+    }
+    return pins;
+}
+
+// 4 - bv <file> [-s]
+// with -s only a summary of the file is printed
 void voters_file(const database db)
 {
     // open the file
-    char* d = strtok(NULL, " ");
-    char* file_name = mystrcpy(d);
+    const char* file_name = strtok(NULL, " ");
+    if (check_malformed(file_name)) return;
+
+    const char* mode = strtok(NULL, " ");
+    const bool summary = (mode != NULL && strcmp(mode, "-s") == 0);
 
-    FILE* file = fopen(file_name, "r");
-    free(file_name);
+    size_t size;
+    const char* file = map_file(file_name, &size);
     if (file == NULL) 
     {
-        printf("%s could not be opened\n\n", file_name);
+        out_printf(responses(), "%s could not be opened\n\n", file_name);
         return;
     }
 
-    char line[LINE_SIZE];  // line buffer
+    // the results are gathered and written with a few large writes
+    const out_buffer out = responses();
+    const out_buffer err = summary? NULL: errors();
 
-    // get each line
-    while (fgets(line, sizeof(line), file))
+    // parse every pin first
+    size_t pins_num, malformed = 0;
+    int* pins = parse_pins(file, size, &pins_num, &malformed, err);
+    unmap_file(file, size);
+
+    // a file with no pins has nothing to search
+    if (pins_num == 0)
     {
-        char *p = strtok(line, " ");
-        if (check_malformed(p)) return;
+        free(pins);
+        if (summary)
+            out_printf(out, "0 Marked Voted\n0 do not exist\n%ld Malformed\n", malformed);
+        out_string(out, "\n\n");
+        return;
+    }
 
-        const int pin = string_to_int(p);
-        if (pin == -1)
+    // then search them all together and mark them
+    voter* found = custom_malloc(pins_num * sizeof(*found));
+    db_search_many(db, pins, pins_num, found);
+
+    size_t marked = 0;
+    for (size_t i = 0; i < pins_num; i++)
+    {
+        const voter v = found[i];
+        if (v != NULL)  // even if voter has already voted come here
         {
-            unsuccessful_response("Malformed Input");
-            continue;
+            if (v->voted == 'n') db_insert_voter(db, v);
+            marked++;
         }
-        
-        if(!db_mark_voted(db, pin))
-            printf("%d does not exist\n", pin);
-        else  // even if voter has already voted come here
-            printf("%d Marked Voted\n", pin);
+        if (summary) continue;
+
+        out_int(out, pins[i]);
+        out_string(out, (v != NULL)? " Marked Voted\n": " does not exist\n");
     }
-    
-    fclose(file);
-    successful_response("");
+    free(found);
+    free(pins);
+
+    if (summary)
+        out_printf(out, "%ld Marked Voted\n%ld do not exist\n%ld Malformed\n", marked, pins_num - marked, malformed);
+    out_string(out, "\n\n");
+}
+
+// reads the last pin of a range that follows its first one, and converts both
+// returns false if they are malformed, or the first is greater than the last
+static bool command_range(const char* p, int* from, int* to)
+{
+    const char* q = strtok(NULL, " ");
+    *from = (p != NULL)? string_to_int(p): -1;
+    *to = (q != NULL)? string_to_int(q): -1;
+    return *from != -1 && *to != -1 && *from <= *to;
 }
 
-// 5 - v
+// reads what v & perc are asked about and counts its participants & voters:
+// nothing for everyone, <first pin> <last pin> for a range of pins or z <zipcode> for a zipcode
+// returns false if it is malformed
+static bool scope_counts(const database db, size_t* participants, size_t* voters)
+{
+    const char* p = strtok(NULL, " ");
+    if (p == NULL)
+    {
+        *participants = get_participants_size(db);
+        *voters = get_voters_size(db);
+        return true;
+    }
+
+    if (strcmp(p, "z") == 0)
+    {
+        p = strtok(NULL, " ");
+        const int zipcode = (p != NULL)? string_to_int(p): -1;
+        if (zipcode == -1) return false;
+
+        db_count_zip(db, zipcode, participants, voters);
+        return true;
+    }
+
+    int from, to;
+    if (!command_range(p, &from, &to)) return false;
+
+    db_count_range(db, from, to, participants, voters);
+    return true;
+}
+
+// 5 - v [<first pin> <last pin> | z <zipcode>]
 void participants_num(const database db)
 {
-    printf("Voted So Far %ld\n\n", get_voters_size(db));
+    size_t participants, voters;
+    if (!scope_counts(db, &participants, &voters))
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+    out_printf(responses(), "Voted So Far %ld\n\n", voters);
 }
 
-// 6 - perc
+// 6 - perc [<first pin> <last pin> | z <zipcode>]
 void vote_percentage(const database db)
 {
-    // get number of participants
-    const size_t participants = get_participants_size(db);
-    
+    size_t participants, voters;
+    if (!scope_counts(db, &participants, &voters))
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+
     // print with a precision of 3
-    printf("%.3f\n\n", (participants == 0)? 0 : (float)get_voters_size(db) / participants * 100);
+    out_printf(responses(), "%.3f\n\n", (participants == 0)? 0 : (float)voters / participants * 100);
 }
 
 // 7 - z <zipcode>
@@ -167,19 +375,143 @@ void zipcode_voters(const database db)
         return;
     }
 
-    print_zipcodes(db->list, zipcode);
+    zip_print(db->zips, zipcode, responses());
 }
 
 // 8 - o
 void postcode_voters(const database db)
 {
-    db_sort(db);
-    sorted_print(db->list);
+    zip_print_ranked(db->zips, responses());
 }
 
 // 10 - p
 void print_db(const database db)
 {
-    hash_print(db->ht);
-    printf("\n");
+    hash_print(db->ht, responses());
+    out_string(responses(), "\n");
+}
+
+// 11 - save <file>
+void save_db(const database db)
+{
+    const char* file_name = strtok(NULL, " ");
+    if (check_malformed(file_name)) return;
+
+    if (db_save(db, file_name))
+        out_printf(responses(), "Saved %s\n\n", file_name);
+    else
+        out_printf(errors(), "%s could not be saved\n\n", file_name);
+}
+
+// a participant of a range, as l prints it
+static void print_participant(const voter v, void* db)
+{
+    out_printf(responses(), "%d %s %s %d %c\n", v->PIN, voter_surname(db, v), voter_name(db, v), v->TK, v->voted);
+}
+
+// 14 - r <first pin> <last pin>
+void range_participants(const database db)
+{
+    int from, to;
+    if (!command_range(strtok(NULL, " "), &from, &to))
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+
+    // the bitmaps count the range at once, so its size comes before its participants
+    size_t participants, voters;
+    db_count_range(db, from, to, &participants, &voters);
+    out_printf(responses(), "%ld participants from %d to %d\n", participants, from, to);
+    db_range(db, from, to, print_participant, db);
+    out_string(responses(), "\n");
+}
+
+// 15 - rperc <first pin> <last pin>
+void range_percentage(const database db)
+{
+    int from, to;
+    if (!command_range(strtok(NULL, " "), &from, &to))
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+
+    size_t participants, voters;
+    db_count_range(db, from, to, &participants, &voters);
+    out_printf(responses(), "%ld of %ld voted, %.3f\n\n", voters, participants, (participants == 0)? 0 : (float)voters / participants * 100);
+}
+
+// 16 - top <k> [perc]
+void top_postcodes(const database db)
+{
+    const char* p = strtok(NULL, " ");
+    if (check_malformed(p)) return;
+
+    const int k = string_to_int(p);
+    const char* mode = strtok(NULL, " ");
+    if (k < 0 || (mode != NULL && strcmp(mode, "perc") != 0))
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+
+    // the ranking by voters is kept in order, the one by percentage is picked out of every zipcode
+    if (mode == NULL) zip_print_top(db->zips, k, responses());
+    else zip_print_top_turnout(db->zips, k, responses());
+}
+
+// 17 - zt [<min percentage> [<max percentage>]]
+void postcode_turnout(const database db)
+{
+    const char* p = strtok(NULL, " ");
+    const char* q = (p != NULL)? strtok(NULL, " "): NULL;
+    const double min = (p != NULL)? string_to_double(p): 0;
+    const double max = (q != NULL)? string_to_double(q): 100;
+    if (min < 0 || max < min)
+    {
+        unsuccessful_response("Malformed Input");
+        return;
+    }
+
+    zip_print_turnout(db->zips, min, max, responses());
+}
+
+command_t read_command(char* line)
+{
+    // process the command
+    command_preprocess(line);
+    if (line[0] == '\0')
+    {
+        unsuccessful_response("Unknown command!");
+        return NO_COMMAND;
+    }
+
+    // tokenize
+    return command_num(strtok(line, " "));
+}
+
+void run_command(const database db, const command_t command_n)
+{
+    switch (command_n)
+    {
+        case FIND_PIN: find_participant(db); break;             // command 1
+        case INSERT_HASH: insert_participant(db); break;        // command 2
+        case VOTED: mark_voted(db); break;                      // command 3
+        case VOTED_FILE: voters_file(db); break;                // command 4
+        case VOTER_NUM: participants_num(db); break;            // command 5
+        case VOTER_PER: vote_percentage(db); break;             // command 6
+        case ZIP_NUM: zipcode_voters(db); break;                // command 7
+        case TK_VOTERS: postcode_voters(db); break;             // command 8
+        case PRINT: print_db(db); break;                        // command 10 - my addition
+        case SAVE: save_db(db); break;                          // command 11
+        case STATS: stats_print(db, responses()); break;                     // command 12
+        case DELETE: delete_participant(db); break;             // command 13
+        case RANGE: range_participants(db); break;              // command 14
+        case RANGE_PER: range_percentage(db); break;            // command 15
+        case TOP: top_postcodes(db); break;                     // command 16
+        case ZIP_TURNOUT: postcode_turnout(db); break;          // command 17
+        case UNRECOGNIZED: unsuccessful_response("unknown command"); break;  // functionality not recognized
+        default: break;  // exit is left to the caller, an empty line was already reported
+    }
 }
@@ -2,26 +2,18 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <sys/mman.h>
 #include "../include/linear_hashing.h"
+#include "../include/linear_hashing_inline.h"
+#include "../include/hash_functions.h"
+#include "../include/zip_index.h"
 #include "../include/list.h"
 #include "../include/utilities.h"
-
-// function that destroys a postalcode and returns the bytes freed
-// needed to create the 1-d list
-size_t destroy_postcode_node(void* p)
-{
-    const postcode post = (postcode)p;
-
-    size_t bytes = 0;
-    bytes += list_destroy(post->voters);
-    bytes += sizeof(*post);
-    free(post);
-
-    return bytes;
-}
-
-// the default hash function of the paper on the K22 site
-hash_t hash_int_default(int val) { return (hash_t)val; }
+#include "../include/arena.h"
+#include "../include/snapshot.h"
+#include "../include/journal.h"
+#include "../include/pin_bitmap.h"
+#include "../include/pin_index.h"
 
 // function that expands the size of the ht by 1
 size_t expand_one(size_t val) { return val+1; }
@@ -30,42 +22,129 @@ size_t expand_one(size_t val) { return val+1; }
 size_t expand_double(size_t val) { return val*2; }
 
 
+const char* voter_name(const database db, const voter v)  { return arena_get(db->strings, v->name); }
+
+const char* voter_surname(const database db, const voter v)  { return arena_get(db->strings, v->surname); }
+
 size_t get_participants_size(const database db)  { return hash_size(db->ht); }
 
-size_t get_voters_size(const database db)  { return db->voters_num; }
+// the lookups of the table specialized for every hash function, so the hash is inlined
+LH_SPECIALIZE(identity, hash_identity, )
+LH_SPECIALIZE(fibonacci, hash_fibonacci, )
+LH_SPECIALIZE(murmur, hash_murmur, )
+#if defined(HAVE_CRC32C)
+LH_SPECIALIZE(crc32c, hash_crc32c, __attribute__((target("sse4.2"))))
+#endif
+
+voter db_search(const database db, const int pin)
+{
+    switch (db->hash_func)
+    {
+        case HASH_IDENTITY: return identity_search(db->ht, pin);
+        case HASH_FIBONACCI: return fibonacci_search(db->ht, pin);
+        case HASH_MURMUR: return murmur_search(db->ht, pin);
+#if defined(HAVE_CRC32C)
+        case HASH_CRC32C: return crc32c_search(db->ht, pin);
+#endif
+        default: return hash_search(db->ht, pin);
+    }
+}
 
-void db_sort(const database db)
+void db_search_many(const database db, const int* pins, const size_t n, voter* found)
 {
-    // if not already sorted sort it
-    if (db->sorted == false)
+    switch (db->hash_func)
     {
-        list_sort(db->list, comp_list);
-        db->sorted = true;
+        case HASH_IDENTITY: identity_search_many(db->ht, pins, n, found); break;
+        case HASH_FIBONACCI: fibonacci_search_many(db->ht, pins, n, found); break;
+        case HASH_MURMUR: murmur_search_many(db->ht, pins, n, found); break;
+#if defined(HAVE_CRC32C)
+        case HASH_CRC32C: crc32c_search_many(db->ht, pins, n, found); break;
+#endif
+        default: hash_search_many(db->ht, pins, n, found);
     }
 }
 
-database db_create(const size_t bucket_size, const size_t st_capacity, const int expand_func)
+size_t get_voters_size(const database db)  { return db->voters_num; }
+
+void db_count_range(const database db, const int from, const int to, size_t* participants, size_t* voters)
+{
+    *participants = bitmap_count_range(db->registered, from, to);
+    *voters = bitmap_count_range(db->voted, from, to);
+}
+
+void db_range(const database db, const int from, const int to, const RangeFunc visit, void* arg)
+{
+    pindex_range(db->ordered, from, to, visit, arg);
+}
+
+void db_count_zip(const database db, const int zipcode, size_t* participants, size_t* voters)
+{
+    const postcode zip = zip_find(db->zips, zipcode);
+    *participants = (zip != NULL)? zip->participants: 0;
+    *voters = (zip != NULL)? list_size(zip->voters): 0;
+}
+
+database db_create(const size_t bucket_size, const size_t st_capacity, const int expand_func, const int hash_func, const voter_pool pool, const string_arena strings)
 {
     const database db = custom_malloc(sizeof(*db));
 
     // initialize data structures
-    db->ht = hash_create(st_capacity, bucket_size, hash_int_default, (expand_func == 2)? expand_double: expand_one);
-    db->list = list_create(destroy_postcode_node);
+    db->hash_func = hash_func;
+    db->ht = hash_create(st_capacity, bucket_size, hash_function(hash_func), (expand_func == 2)? expand_double: expand_one);
+    db->zips = zip_create();
+    db->registered = bitmap_create();
+    db->voted = bitmap_create();
+    db->ordered = pindex_create();
+    db->voters = pool;
+    db->strings = strings;
 
     db->voters_num = 0;
+    db->snapshot = NULL;
+    db->snapshot_size = 0;
+    db->records = NULL;
+    db->records_size = 0;
+    db->log = NULL;
+    db->stats_file = NULL;
+    db->listen_path = NULL;
+    db->batch = false;
+    return db;
+}
+
+// the participant is counted at the bitmaps & its zipcode, and placed at the ordered index
+static void db_index(const database db, const voter v)
+{
+    pindex_insert(db->ordered, v);
+    bitmap_set(db->registered, v->PIN);
+    zip_register(db->zips, v->TK);
+    if (v->voted == 'y') bitmap_set(db->voted, v->PIN);
+}
+
+database db_load(const char* file_name, const int expand_func)
+{
+    const database db = custom_malloc(sizeof(*db));
+    if (!snapshot_load(db, file_name, (expand_func == 2)? expand_double: expand_one))
+    {
+        free(db);
+        return NULL;
+    }
     return db;
 }
 
+bool db_save(const database db, const char* file_name)
+{
+    return snapshot_save(db, file_name);
+}
+
 bool db_insert(const database db, const voter v)
 {
     // try to insert the voter into the database
     if (hash_insert(db->ht, v))
     {
-        // also insert in the 2d list
-        list_insert_postcode(db->list, v);
+        // also insert in the zipcode index
+        zip_insert(db->zips, v);
         v->voted = 'y';
+        db_index(db, v);
         db->voters_num++;
-        db->sorted = false;
         return true;
     }
     // voter already exists
@@ -74,37 +153,114 @@ bool db_insert(const database db, const voter v)
 
 bool db_participant_insert(const database db, const voter v)
 {
-    return hash_insert(db->ht, v);
+    if (!hash_insert(db->ht, v)) return false;
+
+    db_index(db, v);
+    return true;
+}
+
+size_t db_bulk_insert(const database db, voter* voters, const size_t n)
+{
+    if (n == 0) return 0;
+
+    pin_entry* entries = custom_malloc(n * sizeof(*entries));
+    pin_entry* tmp = custom_malloc(n * sizeof(*tmp));
+    for (size_t i = 0; i < n; i++)
+    {
+        entries[i].key = (uint32_t)voters[i]->PIN ^ 0x80000000u;
+        entries[i].v = voters[i];
+    }
+    radix_sort(&entries, &tmp, n);
+    free(tmp);
+
+    // keep the first participant of every pin, reusing the given array
+    const bool check_existing = (hash_size(db->ht) > 0);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if ((i > 0 && entries[i].key == entries[i-1].key) ||
+            (check_existing && db_search(db, entries[i].v->PIN) != NULL))
+            pool_release(db->voters, entries[i].v);
+        else
+            voters[unique++] = entries[i].v;
+    }
+    free(entries);
+
+    hash_bulk_insert(db->ht, voters, unique);
+    for (size_t i = 0; i < unique; i++)
+        db_index(db, voters[i]);
+    return unique;
+}
+
+bool db_add_participant(const database db, const int pin, const char* surname, const char* name, const int zipcode)
+{
+    // check for the participant first, the arena can not take the names back
+    if (db_search(db, pin) != NULL) return false;
+
+    const uint32_t name_offset = arena_append(db->strings, name, strlen(name));
+    const uint32_t surname_offset = arena_append(db->strings, surname, strlen(surname));
+    db_participant_insert(db, create_voter(db->voters, name_offset, surname_offset, pin, zipcode));
+
+    if (db->log != NULL) journal_insert(db->log, pin, surname, name, zipcode);
+    return true;
 }
 
 void db_insert_voter(const database db, const voter v)
 {
     v->voted = 'y';
-    list_insert_postcode(db->list, v);
-    db->sorted = false;
+    zip_insert(db->zips, v);
+    bitmap_set(db->voted, v->PIN);
     db->voters_num++;
+
+    if (db->log != NULL) journal_vote(db->log, v->PIN);
 }
 
 bool db_mark_voted(const database db, const int pin)
 {
-    const voter v = hash_search(db->ht, pin);
+    const voter v = db_search(db, pin);
     if (v != NULL)
     {
         if (v->voted == 'n')  // if voter exists and has not voted, mark him as voted
-        {
-            list_insert_postcode(db->list, v);
-            db->sorted = false;
-            v->voted = 'y';
-            db->voters_num++;
-        }
+            db_insert_voter(db, v);
         return true;
     }
     return false;
 }
 
+bool db_remove(const database db, const int pin)
+{
+    const voter v = hash_remove(db->ht, pin);
+    if (v == NULL) return false;
+
+    if (v->voted == 'y')
+    {
+        zip_remove(db->zips, v);
+        bitmap_clear(db->voted, pin);
+        db->voters_num--;
+    }
+    bitmap_clear(db->registered, pin);
+    zip_unregister(db->zips, v->TK);
+    pindex_remove(db->ordered, pin);
+
+    // the voter is recycled, its names stay in the arena
+    pool_release(db->voters, v);
+
+    if (db->log != NULL) journal_remove(db->log, pin);
+    return true;
+}
+
 size_t db_close(const database db)
 {
-    const size_t total_bytes = sizeof(*db) + list_destroy(db->list) + hash_destroy(db->ht);
+    // the participants are released along with the pool & arena, not one by one
+    // the pending records are made durable before anything goes away
+    size_t total_bytes = (db->log != NULL)? journal_close(db->log): 0;
+    total_bytes += sizeof(*db) + zip_destroy(db->zips) + hash_destroy(db->ht) +
+                   bitmap_destroy(db->registered) + bitmap_destroy(db->voted) + pindex_destroy(db->ordered) +
+                   pool_destroy(db->voters) + arena_destroy(db->strings);
+
+    // the voters & strings of a snapshot live in its mapping, the names of binary records in theirs
+    if (db->snapshot != NULL) munmap(db->snapshot, db->snapshot_size);
+    if (db->records != NULL) munmap(db->records, db->records_size);
     free(db);
     return total_bytes;
 }
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/utilities.h"
+#include "../include/linear_hashing.h"
+#include "../include/concurrent_hashing.h"
+#include "../include/hash_functions.h"
+
+// stress & benchmark of the concurrent hash table
+// every round starts from a table holding the first half of the keys, then its threads share
+// the same number of operations: inserts of the second half and lookups of the first one,
+// every lookup being checked, and at the end every key inserted is looked up again
+// every thread publishes the last key it inserted, and half of the lookups are of the last key a random
+// thread published, which must be found even while the splits it caused are under way
+// usage: ./hash_stress -n <keys> -t <max threads> -w <percent of inserts> -b <bucket size> -h <hash>
+
+#define DEFAULT_KEYS 1000000
+#define DEFAULT_THREADS 8
+#define DEFAULT_INSERTS 10
+
+typedef struct _worker_info worker_info;
+
+typedef struct
+{
+    struct _voter* voters;     // the elements, voters[i] has the i-th key
+    size_t keys;               // the number of keys
+    size_t preloaded;          // the keys inserted before the round starts
+    size_t ops;                // the operations of every thread
+    int inserts;               // the percentage of the operations that are inserts
+    concurrent_hash ht;        // the table of the round
+    pthread_barrier_t start;   // the threads & the timer start together
+    size_t cursor;             // the next key to be inserted
+    size_t errors;             // lookups that did not find their element
+    worker_info* workers;      // the threads of the round
+    int threads_num;           // the number of threads
+}
+round_info;
+
+struct _worker_info
+{
+    round_info* round;
+    uint64_t seed;
+    size_t inserts;            // the inserts made
+    size_t lookups;            // the lookups made
+    size_t published_lookups;  // the lookups of keys published by a thread
+    size_t published;          // the last key inserted + 1, 0 if none yet, stored once the insert is done
+};
+
+// scattered unique keys, multiplying by an odd number is a bijection modulo 2^31
+static inline int key_of(const size_t i)
+{
+    return (int)(((uint64_t)(i + 1) * 2654435761u) & 0x7fffffff);
+}
+
+static inline uint64_t xorshift(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static double elapsed(const struct timespec* from, const struct timespec* to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+static void* worker(void* arg)
+{
+    worker_info* info = arg;
+    round_info* round = info->round;
+    size_t errors = 0;
+
+    pthread_barrier_wait(&round->start);
+    for (size_t i = 0; i < round->ops; i++)
+    {
+        const uint64_t r = xorshift(&info->seed);
+        if ((int)(r % 100) < round->inserts)
+        {
+            const size_t next = __atomic_fetch_add(&round->cursor, 1, __ATOMIC_RELAXED);
+            if (next < round->keys)
+            {
+                chash_insert(round->ht, &round->voters[next]);
+                __atomic_store_n(&info->published, next + 1, __ATOMIC_RELEASE);
+                info->inserts++;
+                continue;
+            }
+        }
+
+        // the last key a thread published, the insert has returned so it must be found
+        if ((r >> 40) & 1)
+        {
+            const worker_info* writer = &round->workers[(r >> 41) % round->threads_num];
+            const size_t published = __atomic_load_n(&writer->published, __ATOMIC_ACQUIRE);
+            if (published != 0)
+            {
+                if (chash_search(round->ht, key_of(published - 1)) != &round->voters[published - 1]) errors++;
+                info->published_lookups++;
+                info->lookups++;
+                continue;
+            }
+        }
+
+        const size_t index = (r >> 8) % round->preloaded;
+        if (chash_search(round->ht, key_of(index)) != &round->voters[index]) errors++;
+        info->lookups++;
+    }
+
+    __atomic_fetch_add(&round->errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// runs a round with the given number of threads, returns false if any lookup failed
+static bool run_round(round_info* round, const int threads_num, const size_t bucket_size, const HashFunc hash)
+{
+    round->ht = chash_create(2, bucket_size, hash);
+    round->cursor = round->preloaded;
+    round->errors = 0;
+    round->ops = round->keys / threads_num;
+    for (size_t i = 0; i < round->preloaded; i++)
+        chash_insert(round->ht, &round->voters[i]);
+
+    pthread_t* threads = custom_malloc(threads_num * sizeof(*threads));
+    worker_info* workers = custom_calloc(threads_num, sizeof(*workers));
+    round->workers = workers;
+    round->threads_num = threads_num;
+    pthread_barrier_init(&round->start, NULL, threads_num + 1);
+    for (int i = 0; i < threads_num; i++)
+    {
+        workers[i].round = round;
+        workers[i].seed = 0x9E3779B97F4A7C15ull * (i + 1);
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    struct timespec from, to;
+    pthread_barrier_wait(&round->start);
+    clock_gettime(CLOCK_MONOTONIC, &from);
+    size_t inserts = 0, lookups = 0, published_lookups = 0;
+    for (int i = 0; i < threads_num; i++)
+    {
+        pthread_join(threads[i], NULL);
+        inserts += workers[i].inserts;
+        lookups += workers[i].lookups;
+        published_lookups += workers[i].published_lookups;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &to);
+
+    // every key inserted must be found, and nothing else must have been inserted
+    const size_t inserted = (round->cursor < round->keys)? round->cursor: round->keys;
+    for (size_t i = 0; i < inserted; i++)
+        if (chash_search(round->ht, key_of(i)) != &round->voters[i]) round->errors++;
+    if (chash_size(round->ht) != inserted) round->errors++;
+
+    printf("%3d threads: %8.2f Mops/s, %ld inserts, %ld lookups (%ld published), %ld buckets, %s\n", threads_num,
+           (inserts + lookups) / elapsed(&from, &to) / 1e6, inserts, lookups, published_lookups, chash_buckets(round->ht),
+           (round->errors == 0)? "ok": "ERRORS");
+
+    pthread_barrier_destroy(&round->start);
+    free(threads);
+    free(workers);
+    chash_destroy(round->ht);
+    return round->errors == 0;
+}
+
+// the same work at the single-threaded table, for reference
+static void run_single(round_info* round, const size_t bucket_size, const HashFunc hash)
+{
+    const hash_table ht = hash_create(2, bucket_size, hash, NULL);
+    for (size_t i = 0; i < round->preloaded; i++)
+        hash_insert(ht, &round->voters[i]);
+
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t cursor = round->preloaded, errors = 0;
+    struct timespec from, to;
+    clock_gettime(CLOCK_MONOTONIC, &from);
+    for (size_t i = 0; i < round->keys; i++)
+    {
+        const uint64_t r = xorshift(&seed);
+        if ((int)(r % 100) < round->inserts && cursor < round->keys)
+        {
+            hash_insert(ht, &round->voters[cursor++]);
+            continue;
+        }
+
+        const size_t index = (r >> 8) % round->preloaded;
+        if (hash_search(ht, key_of(index)) != &round->voters[index]) errors++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &to);
+
+    printf("single-threaded table: %8.2f Mops/s, %s\n", round->keys / elapsed(&from, &to) / 1e6, (errors == 0)? "ok": "ERRORS");
+    hash_destroy(ht);
+}
+
+int main(int argc, char* argv[])
+{
+    int keys = DEFAULT_KEYS, max_threads = DEFAULT_THREADS, inserts = DEFAULT_INSERTS, bucket_size = DEFAULT_BUCKET_SIZE;
+    int hash_func = HASH_FIBONACCI;
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0) keys = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-t") == 0) max_threads = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-w") == 0) inserts = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-b") == 0) bucket_size = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-h") == 0) hash_func = hash_kind_of(argv[i+1]);
+    }
+    if (keys < 2) keys = DEFAULT_KEYS;
+    if (max_threads <= 0) max_threads = DEFAULT_THREADS;
+    if (inserts < 0 || inserts > 100) inserts = DEFAULT_INSERTS;
+    if (bucket_size <= 0) bucket_size = DEFAULT_BUCKET_SIZE;
+    if (hash_func == HASH_FUNCS_NUM || hash_function(hash_func) == NULL) hash_func = HASH_FIBONACCI;
+    const HashFunc hash = hash_function(hash_func);
+
+    round_info round = { 0 };
+    round.keys = keys;
+    round.preloaded = keys / 2;
+    round.inserts = inserts;
+    round.voters = custom_calloc(keys, sizeof(*round.voters));
+    for (int i = 0; i < keys; i++)
+    {
+        round.voters[i].PIN = key_of(i);
+        round.voters[i].voted = 'n';
+    }
+
+    printf("%d keys, %d%% inserts, bucket size %d\n", keys, inserts, bucket_size);
+    run_single(&round, bucket_size, hash);
+
+    bool ok = true;
+    // double the threads every round, ending at the most threads
+    for (int threads = 1; ; threads *= 2)
+    {
+        if (threads > max_threads) threads = max_threads;
+        ok &= run_round(&round, threads, bucket_size, hash);
+        if (threads == max_threads) break;
+    }
+
+    free(round.voters);
+    return ok? EXIT_SUCCESS: EXIT_FAILURE;
+}
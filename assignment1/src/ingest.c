@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/ingest.h"
+#include "../include/utilities.h"
+#include "../include/arena.h"
+
+// the number of fields of a line: <pin> <fname> <lname> <zip>
+#define LINE_FIELDS 4
+
+// a record along with the padding that follows it, the zipcode is read together with the padding
+#define RECORD_SIZE sizeof(struct _voter_record)
+_Static_assert(offsetof(struct _voter_record, zipcode) + sizeof(uint64_t) <= sizeof(struct _voter_record),
+               "the zipcode of a record has to be followed by the padding of the record");
+
+// the bytes of a swar word that are all equal to the byte
+#define SWAR_BYTES(byte) (0x0101010101010101ull * (byte))
+
+// a part of the file that is parsed by a thread, along with the voters found in it
+typedef struct
+{
+    const char* begin;  // the first byte of the chunk
+    const char* end;    // one past the last byte of the chunk
+    voter* voters;      // the voters of the chunk, in the order they were read
+    size_t voters_num;  // the number of voters read
+    size_t capacity;    // the capacity of the voters array
+    voter_pool pool;    // the pool of the chunk, the voters are stored at
+    string_arena strings;  // the arena of the chunk, the names are stored at
+}
+ingest_chunk;
+
+static void chunk_push(ingest_chunk* chunk, const voter v)
+{
+    if (chunk->voters_num == chunk->capacity)
+    {
+        chunk->capacity = (chunk->capacity == 0)? DEFAULT_BULK_CAPACITY: 2*chunk->capacity;
+        chunk->voters = realloc(chunk->voters, chunk->capacity * sizeof(*chunk->voters));
+        if (chunk->voters == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    chunk->voters[chunk->voters_num++] = v;
+}
+
+// parse a line (without its newline) the way strtok splits it on spaces
+// lines with a malformed pin or zip, or with missing fields, are skipped
+static void parse_line(ingest_chunk* chunk, const char* line, const char* end)
+{
+    const char* fields[LINE_FIELDS];
+    size_t lens[LINE_FIELDS];
+
+    int found = 0;
+    for (const char* p = line; found < LINE_FIELDS; found++)
+    {
+        // skip the spaces before the field
+        while (p < end && *p == ' ') p++;
+        if (p == end) return;  // missing field
+
+        fields[found] = p;
+        const char* space = memchr(p, ' ', end - p);
+        p = (space != NULL)? space: end;
+        lens[found] = p - fields[found];
+    }
+
+    const int pin = string_n_to_int(fields[0], lens[0]);
+    if (pin == -1) return;
+
+    const int zip = string_n_to_int(fields[3], lens[3]);
+    if (zip == -1) return;
+
+    const uint32_t name = arena_append(chunk->strings, fields[1], lens[1]);
+    const uint32_t surname = arena_append(chunk->strings, fields[2], lens[2]);
+    chunk_push(chunk, create_voter(chunk->pool, name, surname, pin, zip));
+}
+
+// thread function, parses every line of a chunk
+static void* parse_chunk(void* arg)
+{
+    ingest_chunk* chunk = arg;
+
+    const char* line = chunk->begin;
+    while (line < chunk->end)
+    {
+        const char* newline = memchr(line, '\n', chunk->end - line);
+        const char* line_end = (newline != NULL)? newline: chunk->end;
+
+        parse_line(chunk, line, line_end);
+        line = line_end + 1;
+    }
+    return NULL;
+}
+
+voter* ingest_file(const char* file_name, const int threads, const voter_pool pool, const string_arena strings, size_t* voters_num)
+{
+    size_t size;
+    const char* file = map_file(file_name, &size);
+    if (file == NULL) return NULL;
+
+    *voters_num = 0;
+    if (size == 0) return custom_malloc(sizeof(voter));  // nothing to read
+
+    // small files do not need every thread
+    size_t chunks_num = (threads > 0)? threads: 1;
+    if (chunks_num > MAX_INGEST_THREADS) chunks_num = MAX_INGEST_THREADS;
+    if (chunks_num > size / MIN_INGEST_CHUNK) chunks_num = size / MIN_INGEST_CHUNK;
+    if (chunks_num == 0) chunks_num = 1;
+
+    // split the file into chunks, each ending right after a newline
+    ingest_chunk* chunks = custom_calloc(chunks_num, sizeof(*chunks));
+    const char* const file_end = file + size;
+    const char* begin = file;
+    for (size_t i = 0; i < chunks_num; i++)
+    {
+        const char* end = file_end;
+        if (i < chunks_num-1)
+        {
+            const char* split = file + size * (i+1) / chunks_num;
+            if (split < begin) split = begin;  // the previous chunk took over this one
+
+            const char* newline = memchr(split, '\n', file_end - split);
+            if (newline != NULL) end = newline + 1;
+        }
+
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+
+        // every thread stores its voters on its own, nothing is shared
+        chunks[i].pool = pool_create();
+        chunks[i].strings = arena_create();
+    }
+
+    // parse the chunks, the first one at the calling thread
+    pthread_t* workers = custom_malloc(chunks_num * sizeof(*workers));
+    for (size_t i = 1; i < chunks_num; i++)
+    {
+        if (pthread_create(&workers[i], NULL, parse_chunk, &chunks[i]) != 0)
+        {
+            fprintf(stderr, "Could not create thread. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    parse_chunk(&chunks[0]);
+    for (size_t i = 1; i < chunks_num; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    unmap_file(file, size);
+
+    // merge the voters of the chunks, keeping the order of the file
+    for (size_t i = 0; i < chunks_num; i++) *voters_num += chunks[i].voters_num;
+
+    voter* voters = custom_malloc((*voters_num + 1) * sizeof(*voters));
+    size_t pos = 0;
+    for (size_t i = 0; i < chunks_num; i++)
+    {
+        // the voters & strings move over as whole chunks and pages, only the name offsets change
+        const uint32_t base = arena_merge(strings, chunks[i].strings);
+        pool_merge(pool, chunks[i].pool);
+
+        for (size_t j = 0; j < chunks[i].voters_num; j++)
+        {
+            const voter v = chunks[i].voters[j];
+            v->name += base;
+            v->surname += base;
+            voters[pos++] = v;
+        }
+        free(chunks[i].voters);
+    }
+    free(chunks);
+
+    return voters;
+}
+
+
+// maps the records and enough anonymous memory after them to make up whole pages of the arena
+// returns NULL if the file could not be mapped
+static char* map_records(const char* file_name, size_t* size, size_t* mapping_size)
+{
+    const int fd = open(file_name, O_RDONLY);
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        return NULL;
+    }
+    *size = st.st_size;
+    *mapping_size = (*size + ARENA_PAGE_SIZE - 1) & ~(size_t)(ARENA_PAGE_SIZE - 1);
+    if (*size == 0)  // nothing to map
+    {
+        close(fd);
+        return "";
+    }
+
+    // the file is mapped over the start of the reservation, the bytes past its end read as zero
+    char* mapping = mmap(NULL, *mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+    const bool mapped = (mmap(mapping, *size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED);
+    close(fd);
+    if (!mapped)
+    {
+        munmap(mapping, *mapping_size);
+        return NULL;
+    }
+
+    madvise(mapping, *size, MADV_SEQUENTIAL);
+    return mapping;
+}
+
+// parses the zipcode of a record with its 8 bytes at once, the padding of the record being the last two
+// returns -1 unless it is 1 to 6 digits that end the field or are followed by a null
+static int record_zip(const char* field)
+{
+    uint64_t word;
+    memcpy(&word, field, sizeof(word));
+
+    // a byte is not a digit if its high nibble is not 3, or if adding 6 to it changes its high nibble
+    // the carries of adding 6 only reach the bytes after a byte that is not a digit
+    // the padding is never part of the zipcode, whatever it holds, so its bytes count as not digits
+    const int field_size = sizeof(((struct _voter_record*)NULL)->zipcode);
+    const uint64_t high = SWAR_BYTES(0xF0), threes = SWAR_BYTES(0x30);
+    const uint64_t not_digit = ((word & high) ^ threes) | (((word + SWAR_BYTES(0x06)) & high) ^ threes) | (~0ull << (8 * field_size));
+
+    // the high bit of every non-zero byte, the first one being the first byte that is not a digit, at most the padding
+    const uint64_t lows = SWAR_BYTES(0x7F);
+    const uint64_t marks = (((not_digit & lows) + lows) | not_digit) & SWAR_BYTES(0x80);
+    const int digits = __builtin_ctzll(marks) / 8;
+
+    if (digits == 0 || (digits < field_size && field[digits] != '\0')) return -1;
+
+    // the digits are moved to the top bytes, so the bytes below them are leading zeros
+    // then pairs of digits, pairs of pairs and pairs of those are combined, the first digit being the lowest byte
+    word = (word - threes) << (8 * (8 - digits));
+    word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFull;
+    word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFull;
+    return (int)((word * 10000 + (word >> 32)) & 0xFFFFFFFFull);
+}
+
+// the offset of a name of a record, copied at the arena only if it has no null in its field
+static uint32_t record_name(const string_arena strings, const uint32_t offset, const char* field, const size_t field_size)
+{
+    if (memchr(field, '\0', field_size) != NULL) return offset;
+    return arena_append(strings, field, field_size);
+}
+
+voter* ingest_records(const char* file_name, const voter_pool pool, const string_arena strings, size_t* voters_num,
+                      void** mapping, size_t* mapping_size)
+{
+    size_t size;
+    char* records = map_records(file_name, &size, mapping_size);
+    if (records == NULL) return NULL;
+
+    *voters_num = 0;
+    *mapping = (*mapping_size > 0)? records: NULL;
+
+    // the names are referred to by their offset at the adopted pages, a partial record at the end is ignored
+    const size_t records_num = size / RECORD_SIZE;
+    const uint32_t base = arena_adopt(strings, records, *mapping_size);
+    voter* voters = custom_malloc((records_num + 1) * sizeof(*voters));
+
+    for (size_t i = 0; i < records_num; i++)
+    {
+        const struct _voter_record* record = (const struct _voter_record*)(records + i * RECORD_SIZE);
+        if (record->AM < 0 || record->name[0] == '\0' || record->surname[0] == '\0') continue;
+
+        const int zip = record_zip(record->zipcode);
+        if (zip == -1) continue;
+
+        // the surname of a record is the first name of a line of the voters file, so it is stored as the name
+        const uint32_t offset = base + (uint32_t)(i * RECORD_SIZE);
+        const uint32_t name = record_name(strings, offset + offsetof(struct _voter_record, surname), record->surname, sizeof(record->surname));
+        const uint32_t surname = record_name(strings, offset + offsetof(struct _voter_record, name), record->name, sizeof(record->name));
+        voters[(*voters_num)++] = create_voter(pool, name, surname, record->AM, zip);
+    }
+    return voters;
+}
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../include/journal.h"
+#include "../include/database.h"
+#include "../include/utilities.h"
+
+typedef struct
+{
+    char* data;       // the records gathered
+    size_t used;      // the bytes gathered
+    size_t capacity;  // the capacity of the buffer
+}
+journal_buffer;
+
+struct _journal
+{
+    int fd;                   // the file of the journal
+    journal_buffer active;    // where records are appended
+    journal_buffer spare;     // the records being written, swapped with the active buffer at every commit
+    size_t pending;           // the number of records appended and not yet committed
+    size_t batch;             // the number of pending records that triggers a commit
+    long interval;            // the microseconds a record may wait, 0 if there is no flusher
+    bool running;             // the flusher has to keep going
+    pthread_mutex_t lock;     // guards the active buffer and the pending records
+    pthread_mutex_t sync;     // only one commit writes at a time, so records reach the file in order
+    pthread_cond_t wake;      // wakes the flusher before its interval passes
+    pthread_t flusher;        // commits the records that waited long enough
+};
+
+static void buffer_append(journal_buffer* buffer, const char* str, const size_t n)
+{
+    if (buffer->used + n > buffer->capacity)
+    {
+        size_t new_capacity = (buffer->capacity == 0)? JOURNAL_BUFFER_START: buffer->capacity;
+        while (buffer->used + n > new_capacity) new_capacity *= 2;
+
+        buffer->data = realloc(buffer->data, new_capacity);
+        if (buffer->data == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed. Exiting..\n");
+            exit(EXIT_FAILURE);
+        }
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->data + buffer->used, str, n);
+    buffer->used += n;
+}
+
+void journal_commit(const journal j)
+{
+    pthread_mutex_lock(&j->sync);
+
+    // take the records, appending can go on while they are written
+    pthread_mutex_lock(&j->lock);
+    const journal_buffer taken = j->active;
+    j->active = j->spare;
+    j->spare = taken;
+    j->pending = 0;
+    pthread_mutex_unlock(&j->lock);
+
+    if (j->spare.used > 0)
+    {
+        for (size_t written = 0; written < j->spare.used; )
+        {
+            const ssize_t n = write(j->fd, j->spare.data + written, j->spare.used - written);
+            if (n == -1)
+            {
+                if (errno == EINTR) continue;
+                perror("journal");
+                exit(EXIT_FAILURE);
+            }
+            written += n;
+        }
+        fdatasync(j->fd);
+        j->spare.used = 0;
+    }
+
+    pthread_mutex_unlock(&j->sync);
+}
+
+// commits the pending records once the first of them has waited for the interval,
+// or earlier when a batch fills up
+static void* flush_loop(void* arg)
+{
+    const journal j = arg;
+
+    pthread_mutex_lock(&j->lock);
+    while (j->running)
+    {
+        // sleep until a record arrives
+        while (j->running && j->pending == 0) pthread_cond_wait(&j->wake, &j->lock);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += j->interval * 1000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+
+        // then until the interval passes or a batch fills up
+        while (j->running && j->pending < j->batch)
+            if (pthread_cond_timedwait(&j->wake, &j->lock, &deadline) == ETIMEDOUT) break;
+
+        if (j->pending > 0)
+        {
+            pthread_mutex_unlock(&j->lock);
+            journal_commit(j);
+            pthread_mutex_lock(&j->lock);
+        }
+    }
+    pthread_mutex_unlock(&j->lock);
+    return NULL;
+}
+
+journal journal_open(const char* file_name, const size_t batch, const long interval)
+{
+    const int fd = open(file_name, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd == -1) return NULL;
+
+    const journal j = custom_calloc(1, sizeof(*j));
+    j->fd = fd;
+    j->batch = (batch > 0)? batch: 1;
+    j->interval = (interval > 0)? interval: 0;
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_mutex_init(&j->sync, NULL);
+    pthread_cond_init(&j->wake, NULL);
+
+    if (j->interval > 0)
+    {
+        j->running = true;
+        pthread_create(&j->flusher, NULL, flush_loop, j);
+    }
+    return j;
+}
+
+// appends a record, committing once a batch of them is pending
+static void journal_append(const journal j, const char* record, const size_t n)
+{
+    pthread_mutex_lock(&j->lock);
+    buffer_append(&j->active, record, n);
+    const bool full = (++j->pending >= j->batch);
+    if ((full || j->pending == 1) && j->interval > 0) pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+
+    // without a flusher the batch is committed right here
+    if (full && j->interval == 0) journal_commit(j);
+}
+
+void journal_vote(const journal j, const int pin)
+{
+    char record[32];
+    const int n = snprintf(record, sizeof(record), "m %d\n", pin);
+    journal_append(j, record, n);
+}
+
+void journal_remove(const journal j, const int pin)
+{
+    char record[32];
+    const int n = snprintf(record, sizeof(record), "d %d\n", pin);
+    journal_append(j, record, n);
+}
+
+void journal_insert(const journal j, const int pin, const char* surname, const char* name, const int zipcode)
+{
+    char record[LINE_SIZE];
+    const int n = snprintf(record, sizeof(record), "i %d %s %s %d\n", pin, surname, name, zipcode);
+    if (n < 0 || (size_t)n >= sizeof(record)) return;  // can not be longer than the command it came from
+    journal_append(j, record, n);
+}
+
+// applies a single record, returns true if it is a valid one
+static bool replay_record(char* record, const database db)
+{
+    const char* type = strtok(record, " ");
+    const char* p = strtok(NULL, " ");
+    if (type == NULL || p == NULL) return false;
+
+    const int pin = string_to_int(p);
+    if (pin == -1) return false;
+
+    if (strcmp(type, "m") == 0)
+    {
+        db_mark_voted(db, pin);
+        return true;
+    }
+    else if (strcmp(type, "d") == 0)
+    {
+        db_remove(db, pin);
+        return true;
+    }
+    else if (strcmp(type, "i") == 0)
+    {
+        const char* surname = strtok(NULL, " ");
+        const char* name = strtok(NULL, " ");
+        const char* zip = strtok(NULL, " ");
+        if (surname == NULL || name == NULL || zip == NULL || string_to_int(zip) == -1) return false;
+
+        db_add_participant(db, pin, surname, name, string_to_int(zip));
+        return true;
+    }
+    return false;
+}
+
+long journal_replay(const char* file_name, const database db)
+{
+    size_t size;
+    const char* file = map_file(file_name, &size);
+    if (file == NULL) return -1;
+
+    long applied = 0;
+    char record[LINE_SIZE];
+    const char* const end = file + size;
+    for (const char* line = file; line < end; )
+    {
+        // the last record may have been cut short, only whole lines are applied
+        const char* newline = memchr(line, '\n', end - line);
+        if (newline == NULL) break;
+
+        const size_t n = newline - line;
+        if (n < sizeof(record))
+        {
+            memcpy(record, line, n);
+            record[n] = '\0';
+            if (replay_record(record, db)) applied++;
+        }
+        line = newline + 1;
+    }
+
+    unmap_file(file, size);
+    return applied;
+}
+
+size_t journal_close(const journal j)
+{
+    if (j->interval > 0)
+    {
+        pthread_mutex_lock(&j->lock);
+        j->running = false;
+        pthread_cond_signal(&j->wake);
+        pthread_mutex_unlock(&j->lock);
+        pthread_join(j->flusher, NULL);
+    }
+    journal_commit(j);
+    close(j->fd);
+
+    const size_t bytes = sizeof(*j) + j->active.capacity + j->spare.capacity;
+    pthread_mutex_destroy(&j->lock);
+    pthread_mutex_destroy(&j->sync);
+    pthread_cond_destroy(&j->wake);
+    free(j->active.data);
+    free(j->spare.data);
+    free(j);
+    return bytes;
+}
@@ -5,6 +5,10 @@
 #include "../include/commands.h"
 #include "../include/types.h"
 #include "../include/database.h"
+#include "../include/stats.h"
+#include "../include/output.h"
+#include "../include/server.h"
+#include "../include/batch.h"
 
 int main(int argc, char* argv[])
 {
@@ -19,66 +23,41 @@ int main(int argc, char* argv[])
     // create buffer
     char* buffer = custom_malloc(BUFFER_SIZE * sizeof(char));
 
-    command_t command_n;
-
-    while (true)
+    if (db->listen_path != NULL)  // serve the clients of the socket until stopped
+    {
+        if (!server_run(db, db->listen_path))
+            fprintf(stderr, "%s could not be listened at\n", db->listen_path);
+    }
+    else if (db->batch)  // run the commands piped in a block at a time
+        batch_run(db);
+    else
     {
-        // read command from input
-        fgets(buffer, BUFFER_SIZE, stdin);
+        while (true)
+        {
+            // read command from input
+            fgets(buffer, BUFFER_SIZE, stdin);
 
-        // process the command
-        command_preprocess(buffer);
+            const command_t command_n = read_command(buffer);
+            if (command_n == EXIT)  // command 9
+                break;
+            run_command(db, command_n);
 
-        if (buffer[0] == '\n') continue;
-        else if (buffer[0] == '\0')
-        {
-            unsuccessful_response("Unknown command!");
-            continue;
+            // hand the responses over to stdout & stderr before the next command is read
+            out_flush_std();
         }
-
-        // tokenize
-        char* p = strtok(buffer, " ");
-        
-        if ((command_n = command_num(p)) == FIND_PIN)  // command 1
-            find_participant(db);
-        
-        else if (command_n == INSERT_HASH)  // command 2
-            insert_participant(db);
-        
-        else if (command_n == VOTED)  // command 3
-            mark_voted(db);
-        
-        else if (command_n == VOTED_FILE)  // command 4
-            voters_file(db);
-        
-        else if (command_n == VOTER_NUM)  // command 5
-            participants_num(db);
-        
-        else if (command_n == VOTER_PER)  // command 6
-            vote_percentage(db);
-        
-        else if (command_n == ZIP_NUM)  // command 7
-            zipcode_voters(db);
-        
-        else if (command_n == TK_VOTERS)  // command 8
-            postcode_voters(db);
-        
-        else if (command_n == EXIT)  // command 9
-            break;
-        
-        else if (command_n == PRINT)  // command 10 - my addition
-            print_db(db);
-        
-        else  // functionality not recognized
-            unsuccessful_response("unknown command");
     }
 
     // uncomment to exit before destroying and check with valgrind if the lost bytes are the same as the bytes released below
     // exit(EXIT_SUCCESS);
 
-    // destroy the memory used by the buffer and close the database
+    // keep the statistics of the run, if asked to
+    if (db->stats_file != NULL && !stats_write_json(db, db->stats_file))
+        fprintf(stderr, "%s could not be written\n", db->stats_file);
+
+    // destroy the memory used by the buffers and close the database
+    const size_t buffers_bytes = out_close_std();
     free(buffer);
-    printf("%ld of Bytes Released\n", db_close(db) + BUFFER_SIZE*sizeof(char));
+    printf("%ld of Bytes Released\n", db_close(db) + buffers_bytes + BUFFER_SIZE*sizeof(char));
 
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../include/output.h"
+#include "../include/utilities.h"
+
+struct _out_buffer
+{
+    char* data;       // the output gathered
+    size_t used;      // the number of characters gathered
+    size_t capacity;  // the capacity of the buffer
+    FILE* stream;     // where the output is written, NULL if it is kept
+};
+
+// the buffers of stdout & stderr, created once first used
+static out_buffer std_out = NULL;
+static out_buffer std_err = NULL;
+
+// where the commands write at currently, NULL for stdout & stderr
+static out_buffer redirected_out = NULL;
+static out_buffer redirected_err = NULL;
+
+out_buffer out_create(FILE* stream, const size_t capacity)
+{
+    const out_buffer out = custom_malloc(sizeof(*out));
+    out->capacity = (capacity > 0)? capacity: OUT_BUFFER_SIZE;
+    out->data = custom_malloc(out->capacity);
+    out->used = 0;
+    out->stream = stream;
+    return out;
+}
+
+void out_flush(const out_buffer out)
+{
+    if (out->stream == NULL) return;  // kept until consumed
+
+    // the stream is flushed as well, so output written to it directly keeps its order
+    if (out->used > 0) fwrite(out->data, sizeof(char), out->used, out->stream);
+    fflush(out->stream);
+    out->used = 0;
+}
+
+// grows a buffer with no stream to fit the given number of characters
+static void out_grow(const out_buffer out, const size_t needed)
+{
+    while (out->capacity < needed) out->capacity *= 2;
+    out->data = realloc(out->data, out->capacity);
+    if (out->data == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed. Exiting..\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void out_write(const out_buffer out, const char* str, const size_t n)
+{
+    if (out->used + n > out->capacity && out->stream == NULL)
+        out_grow(out, out->used + n);
+    else if (out->used + n > out->capacity)
+    {
+        out_flush(out);
+
+        // too big to be buffered
+        if (n > out->capacity)
+        {
+            fwrite(str, sizeof(char), n, out->stream);
+            return;
+        }
+    }
+    memcpy(out->data + out->used, str, n);
+    out->used += n;
+}
+
+void out_string(const out_buffer out, const char* str)
+{
+    out_write(out, str, strlen(str));
+}
+
+void out_int(const out_buffer out, const long num)
+{
+    // write the digits backwards
+    char digits[24];
+    size_t pos = sizeof(digits);
+    unsigned long n = (num < 0)? -(unsigned long)num: (unsigned long)num;
+    do
+    {
+        digits[--pos] = '0' + n % 10;
+        n /= 10;
+    }
+    while (n > 0);
+    if (num < 0) digits[--pos] = '-';
+
+    out_write(out, digits + pos, sizeof(digits) - pos);
+}
+
+void out_printf(const out_buffer out, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int n = vsnprintf(out->data + out->used, out->capacity - out->used, format, args);
+    va_end(args);
+    if (n < 0) return;
+
+    if (out->used + n < out->capacity)  // it fit
+    {
+        out->used += n;
+        return;
+    }
+
+    // did not fit, format it again on its own
+    char* str = custom_malloc(n + 1);
+    va_start(args, format);
+    vsnprintf(str, n + 1, format, args);
+    va_end(args);
+    out_write(out, str, n);
+    free(str);
+}
+
+const char* out_data(const out_buffer out)  { return out->data; }
+
+size_t out_size(const out_buffer out)  { return out->used; }
+
+void out_consume(const out_buffer out, const size_t n)
+{
+    const size_t consumed = (n < out->used)? n: out->used;
+    memmove(out->data, out->data + consumed, out->used - consumed);
+    out->used -= consumed;
+}
+
+size_t out_destroy(const out_buffer out)
+{
+    const size_t bytes = sizeof(*out) + out->capacity;
+    out_flush(out);
+    free(out->data);
+    free(out);
+    return bytes;
+}
+
+out_buffer responses(void)
+{
+    if (redirected_out != NULL) return redirected_out;
+    if (std_out == NULL) std_out = out_create(stdout, OUT_BUFFER_SIZE);
+    return std_out;
+}
+
+out_buffer errors(void)
+{
+    if (redirected_err != NULL) return redirected_err;
+    if (std_err == NULL) std_err = out_create(stderr, OUT_BUFFER_SIZE);
+    return std_err;
+}
+
+void out_redirect(const out_buffer out, const out_buffer err)
+{
+    redirected_out = out;
+    redirected_err = err;
+}
+
+// hands the output over to the buffer of its stream, which is flushed as the stream sees fit
+static void out_pass(const out_buffer out)
+{
+    if (out->used > 0) fwrite(out->data, sizeof(char), out->used, out->stream);
+    out->used = 0;
+}
+
+void out_flush_std(void)
+{
+    if (std_out != NULL) out_pass(std_out);
+    if (std_err != NULL) out_pass(std_err);
+}
+
+size_t out_close_std(void)
+{
+    size_t bytes = 0;
+    if (std_out != NULL) bytes += out_destroy(std_out);
+    if (std_err != NULL) bytes += out_destroy(std_err);
+    std_out = std_err = NULL;
+    return bytes;
+}
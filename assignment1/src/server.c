@@ -0,0 +1,310 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "../include/server.h"
+#include "../include/commands.h"
+#include "../include/output.h"
+#include "../include/utilities.h"
+
+typedef struct
+{
+    int fd;            // the socket of the client
+    char* in;          // the bytes received that do not form a whole line yet
+    size_t in_used;    // the number of bytes received
+    bool discarding;   // the rest of a line too long to be served is being dropped
+    out_buffer out;    // the responses & errors not sent yet
+    uint32_t events;   // the events the client is watched for
+    bool closing;      // the client is done, it is closed once everything is sent
+    size_t position;   // the position of the client in the array of clients
+}
+client;
+
+typedef struct
+{
+    int epoll_fd;       // the epoll instance
+    int listen_fd;      // the socket clients connect to
+    client** clients;   // every client connected
+    size_t clients_num; // the number of clients
+    size_t capacity;    // the capacity of the clients array
+}
+server;
+
+// signalled when the server must stop, from whichever thread gets the signal
+static int stop_fd = -1;
+
+static void on_stop(int signal)
+{
+    (void)signal;
+    eventfd_write(stop_fd, 1);
+}
+
+// the commands a client can run, the rest need the terminal
+static bool served(const command_t command_n)
+{
+    return command_n == FIND_PIN || command_n == INSERT_HASH || command_n == VOTED || command_n == VOTED_FILE ||
+           command_n == VOTER_NUM || command_n == VOTER_PER || command_n == ZIP_NUM || command_n == TK_VOTERS ||
+           command_n == DELETE || command_n == RANGE || command_n == RANGE_PER ||
+           command_n == TOP || command_n == ZIP_TURNOUT || command_n == PRINT || command_n == STATS ||
+           command_n == UNRECOGNIZED;
+}
+
+// creates the socket, replacing one left behind by a previous run
+// returns -1 if it could not be created
+static int listen_at(const char* path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    strcpy(address.sun_path, path);
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(fd, SERVER_BACKLOG) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// watch the client for the given events, if it is not already
+static void client_watch(const server* s, client* c, const uint32_t events)
+{
+    if (c->events == events) return;
+
+    struct epoll_event event = { .events = events, .data.ptr = c };
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &event);
+    c->events = events;
+}
+
+static void client_close(server* s, client* c)
+{
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+
+    // the last client takes its place
+    s->clients[c->position] = s->clients[--s->clients_num];
+    s->clients[c->position]->position = c->position;
+
+    out_destroy(c->out);
+    free(c->in);
+    free(c);
+}
+
+static void accept_clients(server* s)
+{
+    int fd;
+    while ((fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        client* c = custom_calloc(1, sizeof(*c));
+        c->fd = fd;
+        c->in = custom_malloc(SERVER_READ_SIZE);
+        c->out = out_create(NULL, SERVER_READ_SIZE);
+        c->events = EPOLLIN;
+
+        if (s->clients_num == s->capacity)
+        {
+            s->capacity = (s->capacity == 0)? SERVER_EVENTS: 2 * s->capacity;
+            s->clients = realloc(s->clients, s->capacity * sizeof(*s->clients));
+            if (s->clients == NULL)
+            {
+                fprintf(stderr, "Memory allocation failed. Exiting..\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        c->position = s->clients_num;
+        s->clients[s->clients_num++] = c;
+
+        struct epoll_event event = { .events = c->events, .data.ptr = c };
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+// runs a line of the client, its responses already redirected to the client
+static void serve_line(const database db, client* c, char* line)
+{
+    const command_t command_n = read_command(line);
+    if (command_n == EXIT)
+        c->closing = true;
+    else if (served(command_n))
+        run_command(db, command_n);
+    else if (command_n != NO_COMMAND)
+        unsuccessful_response("Command not served");
+}
+
+// runs every whole line received, in order
+// with the last flag, what is left is the last line even if it has no newline
+static void serve_lines(const database db, client* c, const bool last)
+{
+    char line[BUFFER_SIZE];
+    size_t start = 0;
+
+    out_redirect(c->out, c->out);
+    while (!c->closing && start < c->in_used)
+    {
+        const char* newline = memchr(c->in + start, '\n', c->in_used - start);
+        if (newline == NULL && !last) break;
+
+        const size_t n = ((newline != NULL)? (size_t)(newline - c->in): c->in_used) - start;
+        if (c->discarding)  // the end of a line too long
+            c->discarding = false;
+        else if (n >= sizeof(line))
+            unsuccessful_response("Malformed Input");
+        else
+        {
+            memcpy(line, c->in + start, n);
+            line[n] = '\0';
+            serve_line(db, c, line);
+        }
+        start += n + 1;
+    }
+
+    // a line that fills the whole buffer can never be served, drop it until its end
+    if (start == 0 && c->in_used == SERVER_READ_SIZE)
+    {
+        if (!c->discarding) unsuccessful_response("Malformed Input");
+        c->discarding = true;
+        c->in_used = 0;
+    }
+    out_redirect(NULL, NULL);
+
+    if (start >= c->in_used)
+        c->in_used = 0;
+    else
+    {
+        memmove(c->in, c->in + start, c->in_used - start);
+        c->in_used -= start;
+    }
+}
+
+// reads what the client sent and serves it
+// returns false if the connection failed
+static bool client_read(const database db, client* c)
+{
+    const ssize_t n = recv(c->fd, c->in + c->in_used, SERVER_READ_SIZE - c->in_used, 0);
+    if (n == -1) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    if (n == 0)  // the client is done sending
+    {
+        serve_lines(db, c, true);
+        c->closing = true;
+        return true;
+    }
+
+    c->in_used += n;
+    serve_lines(db, c, false);
+    return true;
+}
+
+// sends as much of the responses as the socket takes
+// returns false if the connection failed
+static bool client_send(client* c)
+{
+    while (out_size(c->out) > 0)
+    {
+        const ssize_t n = send(c->fd, out_data(c->out), out_size(c->out), MSG_NOSIGNAL);
+        if (n == -1)
+        {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        out_consume(c->out, n);
+    }
+    return true;
+}
+
+static void client_event(server* s, const database db, client* c, const uint32_t events)
+{
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !c->closing && !client_read(db, c))
+    {
+        client_close(s, c);
+        return;
+    }
+
+    if (!client_send(c) || (c->closing && out_size(c->out) == 0))
+    {
+        client_close(s, c);
+        return;
+    }
+
+    // a client that sends commands without reading the responses is not read once they pile up,
+    // so it can not flood the memory of the server
+    uint32_t watched = 0;
+    if (!c->closing && out_size(c->out) < SERVER_OUT_LIMIT) watched |= EPOLLIN;
+    if (out_size(c->out) > 0) watched |= EPOLLOUT;
+    client_watch(s, c, watched);
+}
+
+bool server_run(const database db, const char* path)
+{
+    server s = { .epoll_fd = -1, .listen_fd = listen_at(path) };
+    if (s.listen_fd == -1) return false;
+
+    s.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s.epoll_fd == -1 || stop_fd == -1)
+    {
+        if (s.epoll_fd != -1) close(s.epoll_fd);
+        if (stop_fd != -1) close(stop_fd);
+        close(s.listen_fd);
+        unlink(path);
+        return false;
+    }
+
+    // the listening socket & the stop signal are told apart from the clients by their address
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = &s.listen_fd };
+    epoll_ctl(s.epoll_fd, EPOLL_CTL_ADD, s.listen_fd, &event);
+    event.data.ptr = &stop_fd;
+    epoll_ctl(s.epoll_fd, EPOLL_CTL_ADD, stop_fd, &event);
+
+    struct sigaction stop = { .sa_handler = on_stop }, old_int, old_term;
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGINT, &stop, &old_int);
+    sigaction(SIGTERM, &stop, &old_term);
+
+    struct epoll_event events[SERVER_EVENTS];
+    bool running = true;
+    while (running)
+    {
+        const int events_num = epoll_wait(s.epoll_fd, events, SERVER_EVENTS, -1);
+        if (events_num == -1 && errno != EINTR) break;
+
+        for (int i = 0; i < events_num; i++)
+        {
+            if (events[i].data.ptr == &stop_fd)
+                running = false;
+            else if (events[i].data.ptr == &s.listen_fd)
+                accept_clients(&s);
+            else
+                client_event(&s, db, events[i].data.ptr, events[i].events);
+        }
+    }
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+
+    // the responses that can still be sent are
+    while (s.clients_num > 0)
+    {
+        client_send(s.clients[0]);
+        client_close(&s, s.clients[0]);
+    }
+    free(s.clients);
+
+    close(stop_fd);
+    close(s.epoll_fd);
+    close(s.listen_fd);
+    unlink(path);
+    return true;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/snapshot.h"
+#include "../include/linear_hashing.h"
+#include "../include/zip_index.h"
+#include "../include/arena.h"
+#include "../include/pin_bitmap.h"
+#include "../include/pin_index.h"
+#include "../include/hash_functions.h"
+#include "../include/utilities.h"
+
+typedef struct
+{
+    char magic[8];            // SNAPSHOT_MAGIC
+    uint32_t version;         // SNAPSHOT_VERSION
+    uint32_t voter_size;      // the size of a voter, the layout must match the one of the program
+    uint64_t size;            // the size of the whole snapshot
+    uint64_t hash_func;       // the kind of hash function the buckets were filled with
+    uint64_t voted;           // the number of participants that voted
+    uint64_t voters_offset;   // where the voters start
+    uint64_t voters_num;      // the number of voters
+    uint64_t strings_offset;  // where the pages of the string arena start
+    uint64_t strings_bytes;   // the bytes of the pages
+    uint64_t table_offset;    // where the hash table starts
+    uint64_t zips_offset;     // where the zipcode index starts
+    uint64_t registered_offset;  // where the bitmap of the participants starts
+    uint64_t voted_offset;       // where the bitmap of the voters starts
+    uint64_t ordered_offset;     // where the ordered index of the participants starts
+}
+snapshot_header;
+
+// pads the file with zeros up to the next section, returning the offset of the section
+static bool next_section(FILE* file, uint64_t* offset)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT] = { 0 };
+
+    const long position = ftell(file);
+    if (position < 0) return false;
+
+    const size_t padding = (SNAPSHOT_ALIGNMENT - position % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+    if (padding > 0 && fwrite(zeros, 1, padding, file) != padding) return false;
+
+    *offset = position + padding;
+    return true;
+}
+
+// writes every section, then the header that points to them
+static bool write_snapshot(const database db, FILE* file)
+{
+    snapshot_header header = { .version = SNAPSHOT_VERSION, .voter_size = sizeof(struct _voter), .voted = db->voters_num,
+                               .hash_func = db->hash_func };
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    size_t voters_num, strings_bytes;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        !next_section(file, &header.voters_offset) || !pool_save(db->voters, file, &voters_num) ||
+        !next_section(file, &header.strings_offset) || !arena_save(db->strings, file, &strings_bytes) ||
+        !next_section(file, &header.table_offset) || !hash_save(db->ht, file, db->voters) ||
+        !next_section(file, &header.zips_offset) || !zip_save(db->zips, file, db->voters) ||
+        !next_section(file, &header.registered_offset) || !bitmap_save(db->registered, file) ||
+        !next_section(file, &header.voted_offset) || !bitmap_save(db->voted, file) ||
+        !next_section(file, &header.ordered_offset) || !pindex_save(db->ordered, file, db->voters) ||
+        !next_section(file, &header.size))
+        return false;
+
+    header.voters_num = voters_num;
+    header.strings_bytes = strings_bytes;
+    return fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool snapshot_save(const database db, const char* file_name)
+{
+    // the snapshot is written next to the file and replaces it once it is complete & durable, so the file is
+    // never truncated: it may be the snapshot the database was loaded from, whose voters & strings are still mapped
+    const size_t length = strlen(file_name);
+    char* tmp_name = custom_malloc(length + sizeof(SNAPSHOT_TMP_SUFFIX));
+    memcpy(tmp_name, file_name, length);
+    memcpy(tmp_name + length, SNAPSHOT_TMP_SUFFIX, sizeof(SNAPSHOT_TMP_SUFFIX));
+
+    const int fd = mkstemp(tmp_name);
+    if (fd == -1)
+    {
+        free(tmp_name);
+        return false;
+    }
+
+    // mkstemp creates the file for its owner only, give it the permissions fopen would
+    const mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0666 & ~mask);
+
+    FILE* file = fdopen(fd, "wb");
+    if (file == NULL) close(fd);
+
+    bool written = (file != NULL) && write_snapshot(db, file) && fflush(file) == 0 && fsync(fd) == 0;
+    if (file != NULL && fclose(file) != 0) written = false;
+    written = written && rename(tmp_name, file_name) == 0;
+
+    if (!written) unlink(tmp_name);
+    free(tmp_name);
+    return written;
+}
+
+bool snapshot_load(const database db, const char* file_name, const ExpandFunc expand)
+{
+    const int fd = open(file_name, O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(snapshot_header))
+    {
+        close(fd);
+        return false;
+    }
+
+    // the mapping is private, so marking a voter as voted never reaches the file
+    char* mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const snapshot_header* header = (const snapshot_header*)mapping;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION ||
+        header->voter_size != sizeof(struct _voter) || header->size != (uint64_t)st.st_size ||
+        header->hash_func >= HASH_FUNCS_NUM || hash_function(header->hash_func) == NULL)
+    {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+
+    const voter voters = (voter)(mapping + header->voters_offset);
+
+    db->voters = pool_create();
+    pool_adopt(db->voters, voters, header->voters_num);
+
+    db->strings = arena_create();
+    arena_adopt(db->strings, mapping + header->strings_offset, header->strings_bytes);
+
+    db->hash_func = header->hash_func;
+    db->ht = hash_load(mapping + header->table_offset, voters, hash_function(header->hash_func), expand);
+    db->zips = zip_load(mapping + header->zips_offset, voters);
+    db->registered = bitmap_load(mapping + header->registered_offset);
+    db->voted = bitmap_load(mapping + header->voted_offset);
+    db->ordered = pindex_load(mapping + header->ordered_offset, voters);
+    db->voters_num = header->voted;
+
+    db->log = NULL;
+    db->stats_file = NULL;
+    db->listen_path = NULL;
+    db->batch = false;
+    db->records = NULL;
+    db->records_size = 0;
+    db->snapshot = mapping;
+    db->snapshot_size = st.st_size;
+    return true;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/stats.h"
+#include "../include/linear_hashing.h"
+#include "../include/zip_index.h"
+#include "../include/arena.h"
+#include "../include/pin_bitmap.h"
+#include "../include/pin_index.h"
+#include "../include/output.h"
+
+// the bytes used by every component of the database
+typedef struct
+{
+    size_t voters;     // the voter pool
+    size_t strings;    // the string arena
+    size_t zipcodes;   // the zipcode index
+    size_t bitmaps;    // the bitmaps of the participants & the voters
+    size_t ordered;    // the ordered index of the pins
+    size_t snapshot;   // the snapshot mapping
+}
+component_bytes;
+
+static void get_bytes(const database db, component_bytes* bytes)
+{
+    bytes->voters = pool_bytes(db->voters);
+    bytes->strings = arena_bytes(db->strings);
+    bytes->zipcodes = zip_bytes(db->zips);
+    bytes->bitmaps = bitmap_bytes(db->registered) + bitmap_bytes(db->voted);
+    bytes->ordered = pindex_bytes(db->ordered);
+    bytes->snapshot = db->snapshot_size;
+}
+
+void stats_print(const database db, const out_buffer out)
+{
+    hash_stats stats;
+    hash_get_stats(db->ht, &stats);
+    component_bytes bytes;
+    get_bytes(db, &bytes);
+
+    out_printf(out, "Participants %ld, voted %ld\n", stats.elements, db->voters_num);
+    out_printf(out, "Buckets %ld of %ld elements, load factor %.3f (splits above %.3f)\n", stats.buckets, stats.bucket_size, stats.load_factor, stats.split_load);
+    out_printf(out, "Splits %ld, merges %ld, directory reallocs %ld\n", stats.splits, stats.merges, stats.directory_reallocs);
+
+    out_string(out, "Chains");
+    for (int i = 0; i < HASH_CHAIN_LENGTHS; i++) out_printf(out, " %d:%ld", i, stats.chains[i]);
+    out_printf(out, " %d+:%ld\n", HASH_CHAIN_LENGTHS, stats.chains[HASH_CHAIN_LENGTHS]);
+
+    out_printf(out, "Lookups %ld hits (avg %.2f, max %ld probes), %ld misses (avg %.2f, max %ld probes)\n",
+               stats.hits, stats.avg_hit_probes, stats.max_hit_probes, stats.misses, stats.avg_miss_probes, stats.max_miss_probes);
+
+    out_printf(out, "Bytes directory %ld, segments %ld, buckets %ld, voters %ld, strings %ld, zipcodes %ld, bitmaps %ld, ordered %ld, snapshot %ld\n\n",
+               stats.directory_bytes, stats.segment_bytes, stats.bucket_bytes, bytes.voters, bytes.strings, bytes.zipcodes,
+               bytes.bitmaps, bytes.ordered, bytes.snapshot);
+}
+
+bool stats_write_json(const database db, const char* file_name)
+{
+    FILE* file = fopen(file_name, "w");
+    if (file == NULL) return false;
+
+    hash_stats stats;
+    hash_get_stats(db->ht, &stats);
+    component_bytes bytes;
+    get_bytes(db, &bytes);
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"participants\": %ld,\n  \"voted\": %ld,\n", stats.elements, db->voters_num);
+    fprintf(file, "  \"bucket_size\": %ld,\n  \"buckets\": %ld,\n  \"load_factor\": %.6f,\n  \"split_load\": %.6f,\n",
+            stats.bucket_size, stats.buckets, stats.load_factor, stats.split_load);
+    fprintf(file, "  \"splits\": %ld,\n  \"merges\": %ld,\n  \"directory_reallocs\": %ld,\n", stats.splits, stats.merges, stats.directory_reallocs);
+
+    fprintf(file, "  \"chains\": [");
+    for (int i = 0; i <= HASH_CHAIN_LENGTHS; i++) fprintf(file, (i > 0)? ", %ld": "%ld", stats.chains[i]);
+    fprintf(file, "],\n");
+
+    fprintf(file, "  \"lookups\": {\"hits\": %ld, \"misses\": %ld, \"avg_hit_probes\": %.6f, \"avg_miss_probes\": %.6f, "
+                  "\"max_hit_probes\": %ld, \"max_miss_probes\": %ld},\n",
+            stats.hits, stats.misses, stats.avg_hit_probes, stats.avg_miss_probes, stats.max_hit_probes, stats.max_miss_probes);
+
+    fprintf(file, "  \"bytes\": {\"directory\": %ld, \"segments\": %ld, \"buckets\": %ld, \"voters\": %ld, "
+                  "\"strings\": %ld, \"zipcodes\": %ld, \"bitmaps\": %ld, \"ordered\": %ld, \"snapshot\": %ld}\n",
+            stats.directory_bytes, stats.segment_bytes, stats.bucket_bytes, bytes.voters, bytes.strings, bytes.zipcodes,
+            bytes.bitmaps, bytes.ordered, bytes.snapshot);
+    fprintf(file, "}\n");
+
+    return fclose(file) == 0;
+}
@@ -3,28 +3,55 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "../include/database.h"
 #include "../include/utilities.h"
-#include "../include/list.h"
+#include "../include/ingest.h"
+#include "../include/arena.h"
+#include "../include/journal.h"
+#include "../include/hash_functions.h"
+#include "../include/output.h"
 
 char command_num(char* ans)
 {
     // convert command to lowercase to allow uppercase characters
-    for (size_t i = 0; ans[i] != '\0'; i++)
-        if (isupper(ans[i])) ans[i] = tolower(ans[i]);
-
-    if (strcmp("l", ans) == 0) return FIND_PIN;
-    else if (strcmp("i", ans) == 0) return INSERT_HASH;
-    else if (strcmp("m", ans) == 0) return VOTED;
-    else if (strcmp("bv", ans) == 0) return VOTED_FILE;
-    else if (strcmp("v", ans) == 0) return VOTER_NUM;
-    else if (strcmp("perc", ans) == 0) return VOTER_PER;
-    else if (strcmp("z", ans) == 0) return ZIP_NUM;
-    else if (strcmp("o", ans) == 0) return TK_VOTERS;
-    else if (strcmp("exit", ans) == 0) return EXIT;
-    else if (strcmp("p", ans) == 0) return PRINT;
-
-    else return UNRECOGNIZED;  // command not recognized
+    size_t length = 0;
+    for (; ans[length] != '\0'; length++)
+        if (isupper(ans[length])) ans[length] = tolower(ans[length]);
+
+    // the first character picks the command, the rest is compared at most twice
+    switch (ans[0])
+    {
+        case 'l': if (length == 1) return FIND_PIN; break;
+        case 'i': if (length == 1) return INSERT_HASH; break;
+        case 'm': if (length == 1) return VOTED; break;
+        case 'b': if (length == 2 && ans[1] == 'v') return VOTED_FILE; break;
+        case 'v': if (length == 1) return VOTER_NUM; break;
+        case 'z':
+            if (length == 1) return ZIP_NUM;
+            if (length == 2 && ans[1] == 't') return ZIP_TURNOUT;
+            break;
+        case 't': if (strcmp("top", ans) == 0) return TOP; break;
+        case 'o': if (length == 1) return TK_VOTERS; break;
+        case 'e': if (strcmp("exit", ans) == 0) return EXIT; break;
+        case 'd': if (length == 1) return DELETE; break;
+        case 'p':
+            if (length == 1) return PRINT;
+            if (strcmp("perc", ans) == 0) return VOTER_PER;
+            break;
+        case 's':
+            if (strcmp("save", ans) == 0) return SAVE;
+            if (strcmp("stats", ans) == 0) return STATS;
+            break;
+        case 'r':
+            if (length == 1) return RANGE;
+            if (strcmp("rperc", ans) == 0) return RANGE_PER;
+            break;
+    }
+    return UNRECOGNIZED;  // command not recognized
 }
 
 bool check_malformed(const char* str)
@@ -40,24 +67,27 @@ bool check_malformed(const char* str)
 char* mystrcpy(const char* src)
 {
     // count the characters of the string
-    const size_t num = strlen(src);
+    return mystrncpy(src, strlen(src));
+}
 
-    char* result = custom_calloc(num+1, sizeof(char));
+char* mystrncpy(const char* src, const size_t num)
+{
+    char* result = custom_malloc((num+1) * sizeof(char));
     result[num] = '\0';
 
     // copy
-    for (size_t i = 0; i < num; i++) result[i] = src[i];
+    memcpy(result, src, num * sizeof(char));
     return result;
 }
 
 void successful_response(const char* msg)
 {
-    fprintf(stdout, "%s\n\n", msg);
+    out_printf(responses(), "%s\n\n", msg);
 }
 
 void unsuccessful_response(const char* msg)
 {
-    fprintf(stderr, "%s\n\n", msg);
+    out_printf(errors(), "%s\n\n", msg);
 }
 
 void command_preprocess(char* buff)
@@ -96,93 +126,144 @@ int string_to_int(const char *str)
     return (int)num;
 }
 
-voter create_voter(char* name, char* surname, const int pin, const int zipcode)
+double string_to_double(const char* str)
 {
-    const voter v = custom_malloc(sizeof(*v));
-    v->name = name;
-    v->surname = surname;
-    v->PIN = pin;
-    v->TK = zipcode;
-    v->voted = 'n';  // by default not voted
-    return v;
+    char* end_ptr;
+    const double num = strtod(str, &end_ptr);
+
+    // invalid format was given, return -1
+    if (end_ptr == str || (*end_ptr != '\0' && *end_ptr != '\n')) return -1;
+    return num;
 }
 
-static bool open_file(const database db, const char* file_name)
+int string_n_to_int(const char* str, const size_t n)
 {
-    FILE* file = fopen(file_name, "r");
-    if (file == NULL) return false;
+    char number[16];
+    if (n >= sizeof(number)) return -1;  // does not fit an int
 
-    char line[LINE_SIZE];  // line buffer
+    memcpy(number, str, n);
+    number[n] = '\0';
+    return string_to_int(number);
+}
 
-    // get each line
-    while (fgets(line, sizeof(line), file))
-    {
-        // id
-        char *p = strtok(line, " ");
-        if (p == NULL) continue;
-        const int pin = string_to_int(p);
-        if (pin == -1) continue;
-
-        // fname
-        p = strtok(NULL, " ");
-        if (p == NULL) continue;
-        char* name = mystrcpy(p);
-
-        // lname
-        p = strtok(NULL, " ");
-        if (p == NULL)
-        {
-            free(name);
-            continue;
-        }
-        char* surname = mystrcpy(p);
+const char* map_file(const char* file_name, size_t* size)
+{
+    const int fd = open(file_name, O_RDONLY);
+    if (fd == -1) return NULL;
 
-        // zip
-        p = strtok(NULL, " ");
-        if (p == NULL) 
-        {
-            free(name);
-            free(surname);
-            continue;
-        }
-        const int zip = string_to_int(p);
-        if (zip == -1)
-        {
-            free(name);
-            free(surname);
-            continue;
-        }
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        return NULL;
+    }
 
-        // create a new paricipant and insert him in the database
-        db_participant_insert(db, create_voter(name, surname, pin, zip));
-        // db_participant_insert(db, create_voter(surname, name, pin, zip));
+    *size = st.st_size;
+    if (*size == 0)  // nothing to map
+    {
+        close(fd);
+        return "";
     }
-    
-    fclose(file);
-    return true;
+
+    const char* file = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) return NULL;
+
+    madvise((void*)file, *size, MADV_SEQUENTIAL);
+    return file;
+}
+
+void unmap_file(const char* file, const size_t size)
+{
+    if (size > 0) munmap((void*)file, size);
+}
+
+voter create_voter(const voter_pool pool, const uint32_t name, const uint32_t surname, const int pin, const int zipcode)
+{
+    const voter v = pool_alloc(pool);
+    v->name = name;
+    v->surname = surname;
+    v->PIN = pin;
+    v->TK = zipcode;
+    v->voted = 'n';  // by default not voted
+    return v;
 }
 
 database open_cmd(int argc, char* argv[])
 {
     // look for the correct commandline arguments
     char* file_name = NULL;
+    char* records_name = NULL;
+    char* snapshot_name = NULL;
+    char* journal_name = NULL;
+    char* stats_file = NULL;
+    char* listen_path = NULL;
+    bool batch = false;
+    split_policy policy = split_policy_default();
+    double merge_load = -1;
+    long journal_batch = JOURNAL_DEFAULT_BATCH;
+    long journal_interval = JOURNAL_DEFAULT_INTERVAL;
     int buckets = -1;
     size_t starting_size = 0;
+    bool auto_size = false;
     int expand_func = 0;
+    int hash_func = DEFAULT_HASH_FUNC;
+    int threads = 1;
     for (int i = 1; i < argc; i++)
     {
-        if (argv[i][0] == '-' && strlen(argv[i]) == 2)
+        // the options without a value
+        if (strcmp(argv[i], "-batch") == 0)  // -batch
         {
-            if (i == argc-1) continue;
+            batch = true;
+            continue;
+        }
+        if (i == argc-1) continue;
+
+        // options of the journal
+        if (strcmp(argv[i], "-jb") == 0)  // -jb <records per batch>
+            journal_batch = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-jt") == 0)  // -jt <microseconds>
+            journal_interval = string_to_int(argv[i+1]);
 
+        else if (strcmp(argv[i], "-stats-json") == 0)  // -stats-json <file>
+            stats_file = argv[i+1];
+        else if (strcmp(argv[i], "-listen") == 0)  // -listen <socket path>
+            listen_path = argv[i+1];
+        else if (strcmp(argv[i], "-fb") == 0)  // -fb <binary records file>
+            records_name = argv[i+1];
+
+        // options of the split policy
+        else if (strcmp(argv[i], "-split") == 0)  // -split <load factor>
+            policy.split_load = string_to_double(argv[i+1]);
+        else if (strcmp(argv[i], "-burst") == 0)  // -burst <splits per insert>
+            policy.max_splits = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-chain") == 0)  // -chain <target buckets per chain>
+            policy.target_chain = string_to_double(argv[i+1]);
+        else if (strcmp(argv[i], "-merge") == 0)  // -merge <load factor>
+            merge_load = string_to_double(argv[i+1]);
+
+        else if (argv[i][0] == '-' && strlen(argv[i]) == 2)
+        {
             if (argv[i][1] == 'f')  // -f <file_name>
                 file_name = argv[i+1];
             else if (argv[i][1] == 'b')  // -b <bucket_size>
                 buckets = string_to_int(argv[i+1]);
-            else if (argv[i][1] == 'm')  // -m <starting_size>
-                starting_size = (size_t)string_to_int(argv[i+1]);
+            else if (argv[i][1] == 'm')  // -m <starting_size> | auto
+            {
+                auto_size = (strcmp(argv[i+1], "auto") == 0);
+                const int size = string_to_int(argv[i+1]);
+                starting_size = (size > 0)? (size_t)size: 0;
+            }
             else if (argv[i][1] == 'e')  // -e <expand_function>
                 expand_func = string_to_int(argv[i+1]);
+            else if (argv[i][1] == 't')  // -t <threads>
+                threads = string_to_int(argv[i+1]);
+            else if (argv[i][1] == 's')  // -s <snapshot>
+                snapshot_name = argv[i+1];
+            else if (argv[i][1] == 'j')  // -j <journal>
+                journal_name = argv[i+1];
+            else if (argv[i][1] == 'h')  // -h <hash function>
+                hash_func = hash_kind_of(argv[i+1]);
         }
     }
 
@@ -190,12 +271,114 @@ database open_cmd(int argc, char* argv[])
     if (starting_size == 0) starting_size = DEFAULT_ST_CAPACITY;
     if (expand_func != 1 && expand_func != 2) expand_func = DEFAULT_EXPAND_FUNC;
 
-    const database db = db_create(buckets, starting_size, expand_func);
+    if (threads <= 0) threads = 1;
+    if (hash_func == HASH_FUNCS_NUM) hash_func = DEFAULT_HASH_FUNC;
+    if (policy.split_load <= 0) policy.split_load = SPLIT_DEFAULT_LOAD;
+    if ((int)policy.max_splits <= 0) policy.max_splits = 1;
+    if (policy.target_chain < 0) policy.target_chain = 0;
+
+    // a merge load close to the split load would merge back the buckets just split
+    policy.merge_load = (merge_load >= 0 && merge_load < policy.split_load / 2)? merge_load: policy.split_load / DEFAULT_MERGE_DIVISOR;
+    if (hash_function(hash_func) == NULL)
+    {
+        fprintf(stderr, "The hash function is not supported by this machine\n");
+        return NULL;
+    }
+    if (journal_batch <= 0) journal_batch = JOURNAL_DEFAULT_BATCH;
+    if (journal_interval < 0) journal_interval = JOURNAL_DEFAULT_INTERVAL;
+
+    // start from the snapshot, if that option was given
+    database db = NULL;
+    if (snapshot_name != NULL)
+    {
+        db = db_load(snapshot_name, expand_func);
+        if (db == NULL)
+        {
+            fprintf(stderr, "%s is not a valid snapshot\n", snapshot_name);
+            return NULL;
+        }
+    }
+
+    // the memory of the participants, handed over to the database
+    const voter_pool pool = (db != NULL)? db->voters: pool_create();
+    const string_arena strings = (db != NULL)? db->strings: arena_create();
+
+    // read the file, if that option was given
+    voter* voters = NULL;
+    size_t voters_num = 0;
+    bool read = true;
+    if (file_name != NULL)
+    {
+        voters = ingest_file(file_name, threads, pool, strings, &voters_num);
+        read = (voters != NULL);
+    }
+
+    // then the binary records, if that option was given, whose names stay at their mapping
+    void* records = NULL;
+    size_t records_size = 0;
+    if (read && records_name != NULL)
+    {
+        size_t records_num;
+        voter* record_voters = ingest_records(records_name, pool, strings, &records_num, &records, &records_size);
+        read = (record_voters != NULL);
+        if (read)
+        {
+            voters = realloc(voters, (voters_num + records_num + 1) * sizeof(*voters));
+            if (voters == NULL)
+            {
+                fprintf(stderr, "Memory allocation failed. Exiting..\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(voters + voters_num, record_voters, records_num * sizeof(*voters));
+            voters_num += records_num;
+            free(record_voters);
+        }
+    }
+
+    if (!read)
+    {
+        free(voters);
+        if (db != NULL) db_close(db);
+        else
+        {
+            pool_destroy(pool);
+            arena_destroy(strings);
+        }
+        return NULL;
+    }
+
+    // presize the table for the voters of the files, so that loading them never splits
+    auto_size = auto_size && (file_name != NULL || records_name != NULL);
+    if (db == NULL)
+    {
+        if (auto_size && voters_num > 0) starting_size = hash_presize(voters_num, buckets, policy.split_load);
+        db = db_create(buckets, starting_size, expand_func, hash_func, pool, strings);
+    }
+    hash_set_policy(db->ht, &policy);
 
-    if (file_name != NULL)  // read the file, if that option was given
+    if (auto_size)  // insert the voters in bulk
+        db_bulk_insert(db, voters, voters_num);
+    else  // insert the voters one by one, in the order they were read
     {
-        if (!open_file(db, file_name))
+        for (size_t i = 0; i < voters_num; i++)
+            if (!db_participant_insert(db, voters[i])) pool_release(pool, voters[i]);  // duplicate
+    }
+    free(voters);
+
+    db->records = records;
+    db->records_size = records_size;
+    db->stats_file = stats_file;
+    db->listen_path = listen_path;
+    db->batch = batch;
+
+    // bring back what was journaled since, then keep journaling
+    if (journal_name != NULL)
+    {
+        journal_replay(journal_name, db);
+        db->log = journal_open(journal_name, journal_batch, journal_interval);
+        if (db->log == NULL)
         {
+            fprintf(stderr, "%s could not be opened\n", journal_name);
             db_close(db);
             return NULL;
         }
@@ -204,15 +387,31 @@ database open_cmd(int argc, char* argv[])
     return db;
 }
 
-// compare function used for sorting the list of zipcodes
-// descending order
-int comp_list(void* a, void* b)
+// sort the entries by key with a stable lsd radix sort, one byte per pass
+// being stable, participants with the same pin stay in the order they were read
+void radix_sort(pin_entry** entries, pin_entry** tmp, const size_t n)
 {
-    const postcode l1 = (postcode)a;
-    const postcode l2 = (postcode)b;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        size_t count[256] = { 0 };
+        for (size_t i = 0; i < n; i++) count[((*entries)[i].key >> shift) & 0xFF]++;
 
-    const int ls_1 = list_size(l1->voters);
-    const int ls_2 = list_size(l2->voters);
+        // every entry has the same byte, nothing to do at this pass
+        if (count[((*entries)[0].key >> shift) & 0xFF] == n) continue;
 
-    return ls_2 - ls_1;
+        size_t pos = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            const size_t c = count[i];
+            count[i] = pos;
+            pos += c;
+        }
+
+        for (size_t i = 0; i < n; i++)
+            (*tmp)[count[((*entries)[i].key >> shift) & 0xFF]++] = (*entries)[i];
+
+        pin_entry* swap = *entries;
+        *entries = *tmp;
+        *tmp = swap;
+    }
 }
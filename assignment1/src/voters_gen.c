@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/utilities.h"
+#include "../include/output.h"
+
+// generates a voters file of any size, in the format mvote reads: <pin> <surname> <name> <zipcode>
+// the pins are sequential, random or clustered in runs of consecutive pins,
+// and the zipcodes follow a zipf distribution, the first zipcode being the most common
+// usage: ./voters_gen -n <voters> -p <sequential|random|clustered> -c <cluster size>
+//                     -z <zipcodes> -s <zipcode skew> -seed <seed> -o <file>
+
+#define DEFAULT_VOTERS 100000
+#define DEFAULT_CLUSTER 64
+#define DEFAULT_ZIPS 100
+#define DEFAULT_SKEW 1.0
+#define DEFAULT_SEED 1
+
+// the first pin of a sequential file & the first zipcode
+#define FIRST_PIN 100000
+#define FIRST_ZIP 1000
+
+typedef enum
+{
+    PINS_SEQUENTIAL = 0,
+    PINS_RANDOM,
+    PINS_CLUSTERED,
+    PINS_KINDS_NUM
+}
+pin_kind;
+
+static const char* pin_kinds[PINS_KINDS_NUM] = { "sequential", "random", "clustered" };
+
+// the syllables names are made of
+static const char* syllables[] = { "AN", "BO", "CHRI", "DO", "E", "FRAN", "GEOR", "HE", "IO", "KA",
+                                   "LE", "MA", "NI", "PA", "RA", "SO", "TA", "VA", "XE", "ZE" };
+#define SYLLABLES_NUM (sizeof(syllables) / sizeof(*syllables))
+
+static inline uint64_t xorshift(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// a uniform number in [0, 1)
+static inline double uniform(uint64_t* state)
+{
+    return (xorshift(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// the pin of the i-th voter, every pin being unique
+static int pin_of(const pin_kind kind, const size_t i, const size_t cluster, const int span_bits)
+{
+    switch (kind)
+    {
+        case PINS_RANDOM:  // multiplying by an odd number is a bijection modulo 2^31
+            return (int)(((uint64_t)(i + 1) * 2654435761u) & 0x7fffffff);
+        case PINS_CLUSTERED:  // the clusters are scattered the same way, apart enough not to touch
+        {
+            const uint64_t clusters_mask = (1ull << (31 - span_bits)) - 1;
+            const uint64_t base = ((uint64_t)(i / cluster) * 2654435761u) & clusters_mask;
+            return (int)((base << span_bits) + i % cluster + 1);
+        }
+        default:
+            return (int)(FIRST_PIN + i);
+    }
+}
+
+// appends a name of 2 to 3 syllables
+static void write_name(const out_buffer out, uint64_t* state)
+{
+    const int syllables_num = 2 + xorshift(state) % 2;
+    for (int i = 0; i < syllables_num; i++)
+        out_string(out, syllables[xorshift(state) % SYLLABLES_NUM]);
+}
+
+// the cumulative zipf distribution of the zipcodes, the k-th zipcode having a weight of 1/(k+1)^skew
+static double* zipf_create(const size_t zips, const double skew)
+{
+    double* cdf = custom_malloc(zips * sizeof(*cdf));
+    double sum = 0;
+    for (size_t k = 0; k < zips; k++)
+        cdf[k] = (sum += 1.0 / pow(k + 1, skew));
+    for (size_t k = 0; k < zips; k++)
+        cdf[k] /= sum;
+    return cdf;
+}
+
+// the zipcode a uniform number falls at
+static size_t zipf_pick(const double* cdf, const size_t zips, const double u)
+{
+    size_t low = 0, high = zips - 1;
+    while (low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+        if (cdf[mid] <= u) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+int main(int argc, char* argv[])
+{
+    int voters = DEFAULT_VOTERS, cluster = DEFAULT_CLUSTER, zips = DEFAULT_ZIPS, seed = DEFAULT_SEED;
+    double skew = DEFAULT_SKEW;
+    pin_kind kind = PINS_SEQUENTIAL;
+    const char* file_name = NULL;
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0) voters = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-c") == 0) cluster = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-z") == 0) zips = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-s") == 0) skew = string_to_double(argv[i+1]);
+        else if (strcmp(argv[i], "-seed") == 0) seed = string_to_int(argv[i+1]);
+        else if (strcmp(argv[i], "-o") == 0) file_name = argv[i+1];
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            for (kind = 0; kind < PINS_KINDS_NUM; kind++)
+                if (strcmp(argv[i+1], pin_kinds[kind]) == 0) break;
+        }
+    }
+    if (voters <= 0) voters = DEFAULT_VOTERS;
+    if (cluster <= 0) cluster = DEFAULT_CLUSTER;
+    if (zips <= 0) zips = DEFAULT_ZIPS;
+    if (skew < 0) skew = DEFAULT_SKEW;
+    if (seed <= 0) seed = DEFAULT_SEED;
+    if (kind == PINS_KINDS_NUM)
+    {
+        fprintf(stderr, "The pins can be sequential, random or clustered\n");
+        return EXIT_FAILURE;
+    }
+
+    // a cluster takes the next power of two that is at least twice its size, the rest is the gap to the next one
+    int span_bits = 1;
+    while ((1 << span_bits) < 2 * cluster) span_bits++;
+    if (kind == PINS_CLUSTERED && (span_bits > 30 || (uint64_t)voters / cluster >= (1ull << (31 - span_bits))))
+    {
+        fprintf(stderr, "The clusters do not fit in the pins\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE* file = (file_name != NULL)? fopen(file_name, "w"): stdout;
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s could not be opened\n", file_name);
+        return EXIT_FAILURE;
+    }
+
+    double* cdf = zipf_create(zips, skew);
+    uint64_t state = 0x9E3779B97F4A7C15ull * seed;
+    const out_buffer out = out_create(file, OUT_BUFFER_SIZE);
+    for (size_t i = 0; i < (size_t)voters; i++)
+    {
+        out_int(out, pin_of(kind, i, cluster, span_bits));
+        out_write(out, " ", 1);
+        write_name(out, &state);
+        out_write(out, " ", 1);
+        write_name(out, &state);
+        out_write(out, " ", 1);
+        out_int(out, FIRST_ZIP + zipf_pick(cdf, zips, uniform(&state)));
+        out_write(out, "\n", 1);
+    }
+    out_destroy(out);
+
+    free(cdf);
+    if (file != stdout) fclose(file);
+    return EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "common.h"
+#include "../../assignment1/include/split_policy.h"  // shared with the linear hashing of assignment1
 
 // value types we need
 typedef unsigned int hash_t;
@@ -28,6 +29,9 @@ typedef struct _linear_hash* hash_table;
 // the default expand function
 hash_table hash_create(const size_t, const size_t, const HashFunc, const ExpandFunc);
 
+// set when the hash table splits its buckets, the default being split_policy_default
+void hash_set_policy(const hash_table, const split_policy*);
+
 // get the number of elements currently inserted in the hash table
 size_t hash_size(const hash_table);
 
@@ -3,9 +3,6 @@
 #include <string.h>
 #include "hash_table.h"
 
-// when to split
-#define LAMDA_SPLIT 0.75
-
 // wrap the data in a struct
 typedef struct data_info
 {
@@ -35,6 +32,8 @@ struct _linear_hash
     size_t powi_1;         // 2^(i+1) * m
     HashFunc hash;         // hash function
     ExpandFunc expand;     // expand function
+    split_policy policy;   // when buckets are split
+    size_t buckets_used;   // the buckets allocated, overflow ones included
 };
 
 // by default grow by one
@@ -61,13 +60,14 @@ hash_table hash_create(const size_t m, const size_t bucket_size, const HashFunc
     ht->powi = m;      // i = 0 so 2^0 * m = 1 * m = m
     ht->powi_1 = 2*m;  // i = 1 so 2^1 * m = 2 * m
     ht->capacity = ht->curr_capacity * ht->bucket_size;
+    ht->policy = split_policy_default();
     return ht;
 }
 
-static inline float calculate_lamda(const hash_table ht)
+void hash_set_policy(const hash_table ht, const split_policy* policy)
 {
-    // elemnts / capacity in non overflow buckets
-    return (float)ht->elements_num / ht->capacity;
+    ht->policy = *policy;
+    if (ht->policy.max_splits == 0) ht->policy.max_splits = 1;
 }
 
 size_t hash_size(const hash_table ht)  { return ht->elements_num; }
@@ -79,6 +79,7 @@ static inline node create_bucket(const hash_table ht)
     new_bucket->data = custom_malloc(ht->bucket_size * sizeof(*new_bucket->data));
     new_bucket->number_used = 0;
     new_bucket->next_bucket = NULL;
+    ht->buckets_used++;
     return new_bucket;
 }
 
@@ -91,6 +92,7 @@ static inline void insert_bucket(const hash_table ht, const size_t index)
 
     new_bucket->next_bucket = ht->nodes[index];
     ht->nodes[index] = new_bucket;
+    ht->buckets_used++;
 }
 
 // calculate the hash value of the key
@@ -171,6 +173,7 @@ static inline void temp_insert(const hash_table ht, const data_t key, node* buck
         
         new_bucket->next_bucket = *bucket;
         *bucket = new_bucket;
+        ht->buckets_used++;
     }
 }
 
@@ -201,6 +204,7 @@ static inline void bucket_split(const hash_table ht)
         buckets = buckets->next_bucket;
         free(tmp->data);
         free(tmp);
+        ht->buckets_used--;
     }
 
     ht->nodes[ht->p] = new_buckets;
@@ -225,8 +229,10 @@ char *hash_insert(const hash_table ht, const data_t value)
     // value inserted
     ht->elements_num++;
     
-    // lamda exceeded the limit, split
-    if (calculate_lamda(ht) > LAMDA_SPLIT)
+    split_policy_adapt(&ht->policy, ht->buckets_used, ht->curr_capacity);
+
+    // lamda exceeded the limit of the policy, split as many buckets as it asks for
+    for (size_t splits = split_policy_splits(&ht->policy, ht->elements_num, ht->capacity, ht->bucket_size); splits > 0; splits--)
     {
         // hash table needs resizing
         hash_resize(ht);